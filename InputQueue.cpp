@@ -0,0 +1,43 @@
+#include "InputQueue.h"
+#include "SDL3/SDL.h"
+
+namespace mario
+{
+    void InputQueue::start()
+    {
+        _quit.store(false, std::memory_order_release);
+        SDL_AddEventWatch(&InputQueue::watch, nullptr);
+    }
+
+    void InputQueue::stop()
+    {
+        SDL_RemoveEventWatch(&InputQueue::watch, nullptr);
+    }
+
+    void InputQueue::waitFor(Uint32 ms)
+    {
+        SDL_Event event;
+        const Uint64 end = SDL_GetTicks() + ms;
+        for (Uint64 now = SDL_GetTicks(); now < end; now = SDL_GetTicks())
+            SDL_WaitEventTimeout(&event, static_cast<Sint32>(end - now));
+    }
+
+    bool InputQueue::watch(void*, SDL_Event* event)
+    {
+        switch (event->type) {
+            case SDL_EVENT_QUIT:
+                _quit.store(true, std::memory_order_release);
+                break;
+            case SDL_EVENT_KEY_DOWN:
+            case SDL_EVENT_KEY_UP:
+                if (event->key.repeat)
+                    break;
+                if (!_events.push({event->key.timestamp, event->key.scancode, event->key.down}))
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+}
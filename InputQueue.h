@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include "SDL3/SDL.h"
+
+namespace mario {
+
+    /// @brief Lock-free ring buffer for exactly one producer thread and one consumer thread.
+    template <class T, std::size_t N>
+    class SpscRing
+    {
+        static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+    public:
+        /// @brief Adds t; returns false and drops it when the ring is full.
+        bool push(const T& t) {
+            const std::size_t head = _head.load(std::memory_order_relaxed);
+            if (head - _tail.load(std::memory_order_acquire) == N)
+                return false;
+            _buf[head & (N - 1)] = t;
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T& t) {
+            const std::size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail == _head.load(std::memory_order_acquire))
+                return false;
+            t = _buf[tail & (N - 1)];
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Calls f on every queued element in order and releases them in one batch.
+        template <class F>
+        std::size_t drain(F&& f) {
+            const std::size_t tail = _tail.load(std::memory_order_relaxed);
+            const std::size_t head = _head.load(std::memory_order_acquire);
+            for (std::size_t i = tail; i != head; ++i)
+                f(_buf[i & (N - 1)]);
+            _tail.store(head, std::memory_order_release);
+            return head - tail;
+        }
+
+    private:
+        alignas(64) std::atomic<std::size_t> _head{0}; // Next slot the producer writes
+        alignas(64) std::atomic<std::size_t> _tail{0}; // Next slot the consumer reads
+        alignas(64) T _buf[N];
+    };
+
+    /// @brief InputEvent holds one key change and the time SDL sampled it.
+    struct InputEvent {
+        Uint64 timestamp; // SDL event timestamp in nanoseconds
+        SDL_Scancode scancode; // Physical key
+        bool down; // Whether the key was pressed or released
+    };
+
+    /// @brief Captures key events the moment SDL delivers them, independent of the frame loop.
+    ///
+    /// An SDL event watch is the single producer: it timestamps each key change and pushes it
+    /// into a lock-free ring, which InputSystem drains once per tick. SDL only pumps events on
+    /// the main thread, so frame loops wait with waitFor() instead of SDL_Delay to keep
+    /// sampling while they sleep.
+    class InputQueue
+    {
+    public:
+        static constexpr std::size_t CAPACITY = 256;
+
+        static void start();
+        static void stop();
+
+        static SpscRing<InputEvent, CAPACITY>& events() { return _events; }
+
+        /// @brief Whether a quit event was seen since start().
+        static bool quitRequested() { return _quit.load(std::memory_order_acquire); }
+
+        /// @brief Events dropped because the ring was full.
+        static std::size_t dropped() { return _dropped.load(std::memory_order_relaxed); }
+
+        /// @brief Waits ms milliseconds while pumping events as they arrive.
+        static void waitFor(Uint32 ms);
+
+    private:
+        static bool watch(void* userdata, SDL_Event* event);
+
+        static inline SpscRing<InputEvent, CAPACITY> _events;
+        static inline std::atomic<bool> _quit{false};
+        static inline std::atomic<std::size_t> _dropped{0};
+    };
+}
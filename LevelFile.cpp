@@ -0,0 +1,180 @@
+#include "LevelFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace mario
+{
+    static_assert(std::is_trivially_copyable_v<Spawn>, "Spawn is stored in level files as is");
+    static_assert(std::is_trivially_copyable_v<BodyBox>, "BodyBox is stored in level files as is");
+    static_assert(std::is_trivially_copyable_v<TileDef>, "TileDef is stored in level files as is");
+
+    namespace {
+        constexpr char MAGIC[4] = {'B', 'G', 'L', 'V'};
+        constexpr std::uint32_t VERSION = 1;
+
+        std::uint64_t align(std::uint64_t offset) { return (offset + 7) & ~std::uint64_t(7); }
+
+        // Whether count elements of type T starting at offset lie inside a file of size bytes
+        template <class T>
+        bool fits(std::uint64_t offset, std::int64_t count, std::size_t size) {
+            return count >= 0 && offset % alignof(T) == 0 && offset <= size &&
+                   static_cast<std::uint64_t>(count) <= (size - offset) / sizeof(T);
+        }
+    }
+
+    struct LevelFile::Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t spawnSize; // sizeof(Spawn) of the compiler; the layout must match
+        std::int32_t columns, rows;
+        std::int32_t tileDefCount, regionCount, spawnCount, solidCount;
+        std::uint64_t tiles, tileDefs, regions, spawns, bodies, solids; // Section offsets
+    };
+
+    void LevelData::mergeSolids()
+    {
+        bool solid[256] = {};
+        for (const TileDef& def : tileDefs)
+            solid[def.symbol] = def.solid;
+
+        const float size = static_cast<float>(LEVEL_TILE_SIZE);
+        const float half = size / 2.f;
+        solids.clear();
+        for (int row = 0; row < rows; ++row) {
+            int column = 0;
+            while (column < columns) {
+                if (!solid[tiles[static_cast<std::size_t>(row) * columns + column]]) {
+                    ++column;
+                    continue;
+                }
+                const int start = column;
+                while (column < columns && solid[tiles[static_cast<std::size_t>(row) * columns + column]])
+                    ++column;
+
+                const float halfWidth = (column - start) * half;
+                solids.push_back({start * size + halfWidth, row * size + half, halfWidth, half});
+            }
+        }
+    }
+
+    LevelFile::LevelFile(const char* path) : _file(path)
+    {
+        if (_file.size() < sizeof(Header))
+            return;
+
+        const Header* header = static_cast<const Header*>(_file.data());
+        if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+            header->spawnSize != sizeof(Spawn))
+            return;
+
+        // Every section must lie inside the file, so a truncated or corrupt file is rejected
+        // here instead of being read past the mapping
+        const std::size_t size = _file.size();
+        if (header->columns < 0 || header->rows < 0 || header->regionCount < 0 ||
+            !fits<std::uint8_t>(header->tiles, std::int64_t(header->columns) * header->rows, size) ||
+            !fits<TileDef>(header->tileDefs, header->tileDefCount, size) ||
+            !fits<std::uint32_t>(header->regions, std::int64_t(header->regionCount) + 1, size) ||
+            !fits<Spawn>(header->spawns, header->spawnCount, size) ||
+            !fits<BodyBox>(header->bodies, header->spawnCount, size) ||
+            !fits<BodyBox>(header->solids, header->solidCount, size))
+            return;
+
+        // The region table must split the spawns into consecutive runs
+        const std::uint32_t* first = section<std::uint32_t>(header->regions);
+        if (first[0] != 0 || first[header->regionCount] != static_cast<std::uint32_t>(header->spawnCount))
+            return;
+        for (int i = 0; i < header->regionCount; ++i)
+            if (first[i + 1] < first[i])
+                return;
+
+        _header = header;
+    }
+
+    int LevelFile::columns() const { return _header->columns; }
+    int LevelFile::rows() const { return _header->rows; }
+    const std::uint8_t* LevelFile::tiles() const { return section<std::uint8_t>(_header->tiles); }
+
+    const TileDef* LevelFile::tileDefs() const { return section<TileDef>(_header->tileDefs); }
+    int LevelFile::tileDefCount() const { return _header->tileDefCount; }
+
+    int LevelFile::regionCount() const { return _header->regionCount; }
+
+    const Spawn* LevelFile::spawns(int region) const
+    {
+        return section<Spawn>(_header->spawns) + section<std::uint32_t>(_header->regions)[region];
+    }
+
+    const BodyBox* LevelFile::bodies(int region) const
+    {
+        return section<BodyBox>(_header->bodies) + section<std::uint32_t>(_header->regions)[region];
+    }
+
+    int LevelFile::spawnCount(int region) const
+    {
+        const std::uint32_t* first = section<std::uint32_t>(_header->regions);
+        return static_cast<int>(first[region + 1] - first[region]);
+    }
+
+    const BodyBox* LevelFile::solids() const { return section<BodyBox>(_header->solids); }
+    int LevelFile::solidCount() const { return _header->solidCount; }
+
+    bool LevelFile::write(const char* path, const LevelData& level)
+    {
+        std::vector<Spawn> spawns = level.spawns;
+        std::stable_sort(spawns.begin(), spawns.end(), [](const Spawn& a, const Spawn& b) {
+            return regionOf(a.x) < regionOf(b.x);
+        });
+
+        const int regionCount = spawns.empty() ? 0 : regionOf(spawns.back().x) + 1;
+        std::vector<std::uint32_t> regions(regionCount + 1, 0);
+        std::vector<BodyBox> bodies;
+        bodies.reserve(spawns.size());
+        for (const Spawn& s : spawns) {
+            ++regions[regionOf(s.x) + 1];
+            bodies.push_back(bodyOf(s));
+        }
+        for (int i = 0; i < regionCount; ++i)
+            regions[i + 1] += regions[i];
+
+        Header header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.spawnSize = sizeof(Spawn);
+        header.columns = level.columns;
+        header.rows = level.rows;
+        header.tileDefCount = static_cast<std::int32_t>(level.tileDefs.size());
+        header.regionCount = regionCount;
+        header.spawnCount = static_cast<std::int32_t>(spawns.size());
+        header.solidCount = static_cast<std::int32_t>(level.solids.size());
+        header.tiles = align(sizeof(Header));
+        header.tileDefs = align(header.tiles + level.tiles.size());
+        header.regions = align(header.tileDefs + level.tileDefs.size() * sizeof(TileDef));
+        header.spawns = align(header.regions + regions.size() * sizeof(std::uint32_t));
+        header.bodies = align(header.spawns + spawns.size() * sizeof(Spawn));
+        header.solids = align(header.bodies + bodies.size() * sizeof(BodyBox));
+
+        std::FILE* file = std::fopen(path, "wb");
+        if (file == nullptr)
+            return false;
+
+        std::uint64_t offset = 0;
+        const auto put = [&](std::uint64_t at, const void* data, std::size_t size) {
+            static const char zeros[8] = {};
+            std::fwrite(zeros, 1, at - offset, file);
+            std::fwrite(data, 1, size, file);
+            offset = at + size;
+        };
+        put(0, &header, sizeof(header));
+        put(header.tiles, level.tiles.data(), level.tiles.size());
+        put(header.tileDefs, level.tileDefs.data(), level.tileDefs.size() * sizeof(TileDef));
+        put(header.regions, regions.data(), regions.size() * sizeof(std::uint32_t));
+        put(header.spawns, spawns.data(), spawns.size() * sizeof(Spawn));
+        put(header.bodies, bodies.data(), bodies.size() * sizeof(BodyBox));
+        put(header.solids, level.solids.data(), level.solids.size() * sizeof(BodyBox));
+
+        const bool ok = std::ferror(file) == 0;
+        return std::fclose(file) == 0 && ok;
+    }
+}
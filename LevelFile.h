@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "LevelTypes.h"
+#include "MappedFile.h"
+
+namespace mario {
+
+    /// @brief LevelData is a compiled level held in memory, as the level compiler builds it.
+    struct LevelData {
+        int columns = 0, rows = 0;
+        std::vector<std::uint8_t> tiles; // columns * rows static tile ids, row by row
+        std::vector<TileDef> tileDefs;
+        std::vector<Spawn> spawns; // Dynamic entities, in any order
+        std::vector<BodyBox> solids; // Colliders of the static tiles, one per horizontal run
+
+        /// @brief Fills solids with one box per horizontal run of solid tiles.
+        void mergeSolids();
+    };
+
+    /// @brief A compiled level mapped read-only into memory.
+    ///
+    /// File layout: a header followed by 8-byte aligned sections holding the tile grid,
+    /// the tile definitions, the spawns sorted by LevelStreamer region with a per-region
+    /// offset table, one prebuilt BodyBox per spawn and the merged static colliders.
+    /// Every section is laid out as the runtime reads it, so nothing is parsed or copied
+    /// on load: LevelStreamer and Tilemap point into the mapping, and processes that load
+    /// the same level share its pages.
+    class LevelFile
+    {
+    public:
+        explicit LevelFile(const char* path);
+
+        LevelFile(const LevelFile&) = delete;
+        LevelFile& operator=(const LevelFile&) = delete;
+
+        bool isOpen() const { return _header != nullptr; }
+
+        int columns() const;
+        int rows() const;
+        const std::uint8_t* tiles() const;
+
+        const TileDef* tileDefs() const;
+        int tileDefCount() const;
+
+        int regionCount() const;
+        /// @brief Spawns of a region and their bodies, both spawnCount(region) long.
+        const Spawn* spawns(int region) const;
+        const BodyBox* bodies(int region) const;
+        int spawnCount(int region) const;
+
+        const BodyBox* solids() const;
+        int solidCount() const;
+
+        /// @brief Writes level to path in the layout LevelFile maps.
+        static bool write(const char* path, const LevelData& level);
+
+    private:
+        struct Header;
+
+        template <class T>
+        const T* section(std::uint64_t offset) const {
+            return reinterpret_cast<const T*>(static_cast<const char*>(_file.data()) + offset);
+        }
+
+        MappedFile _file;
+        const Header* _header = nullptr;
+    };
+}
@@ -0,0 +1,137 @@
+#include "LevelStreamer.h"
+#include <algorithm>
+#include "box2d/box2d.h"
+#include "bagel.h"
+#include "LevelFile.h"
+
+namespace mario
+{
+    LevelStreamer::LevelStreamer(b2WorldId world, float boxScale, float loadAhead, float unloadBehind)
+        : _world(world), _boxScale(boxScale), _loadAhead(loadAhead), _unloadBehind(unloadBehind)
+    {
+    }
+
+    LevelStreamer::~LevelStreamer()
+    {
+        unloadAll();
+    }
+
+    void LevelStreamer::add(const Spawn& spawn)
+    {
+        const int index = regionOf(spawn.x);
+        if (index >= static_cast<int>(_regions.size()))
+            _regions.resize(index + 1);
+        _regions[index].spawns.push_back(spawn);
+        _regions[index].consumed.push_back(false);
+    }
+
+    void LevelStreamer::adopt(const LevelFile& level)
+    {
+        unloadAll();
+        _regions.clear();
+        _regions.resize(level.regionCount());
+        for (int index = 0; index < level.regionCount(); ++index) {
+            Region& region = _regions[index];
+            region.adopted = level.spawns(index);
+            region.bodies = level.bodies(index);
+            region.adoptedCount = level.spawnCount(index);
+            region.consumed.assign(region.adoptedCount, false);
+        }
+    }
+
+    void LevelStreamer::update(const Position& cam, const Camera& camera)
+    {
+        const float keepLeft = cam.x - _unloadBehind;
+        const float keepRight = cam.x + camera.width + _unloadBehind;
+
+        for (std::size_t i = 0; i < _loaded.size();) {
+            const int index = _loaded[i];
+            const float left = index * REGION_WIDTH;
+            if (left + REGION_WIDTH < keepLeft || left > keepRight) {
+                unload(index);
+                _loaded[i] = _loaded.back();
+                _loaded.pop_back();
+            } else {
+                ++i;
+            }
+        }
+
+        const int first = std::max(0, static_cast<int>((cam.x - _loadAhead) / REGION_WIDTH));
+        const int last = std::min(static_cast<int>(_regions.size()) - 1,
+                                  static_cast<int>((cam.x + camera.width + _loadAhead) / REGION_WIDTH));
+        for (int index = first; index <= last; ++index) {
+            if (!_regions[index].loaded) {
+                load(index);
+                _loaded.push_back(index);
+            }
+        }
+    }
+
+    void LevelStreamer::unloadAll()
+    {
+        for (int index : _loaded)
+            unload(index);
+        _loaded.clear();
+    }
+
+    void LevelStreamer::load(int index)
+    {
+        Region& region = _regions[index];
+        region.loaded = true;
+        region.live.reserve(region.spawns.size() + region.adoptedCount);
+        for (int i = 0; i < region.adoptedCount; ++i)
+            if (!region.consumed[i])
+                spawn(region.adopted[i], region.bodies[i], index, i);
+        for (std::size_t i = 0; i < region.spawns.size(); ++i)
+            if (!region.consumed[region.adoptedCount + i])
+                spawn(region.spawns[i], bodyOf(region.spawns[i]), index, region.adoptedCount + static_cast<int>(i));
+    }
+
+    void LevelStreamer::unload(int index)
+    {
+        Region& region = _regions[index];
+        _doomed.clear();
+        for (const Live& live : region.live) {
+            bagel::Entity entity{live.ent};
+            // An entity destroyed while loaded, whose id may since have been reused, was consumed
+            const bool exists = entity.has<Streamed>() && entity.get<Streamed>().region == index &&
+                                entity.get<Streamed>().serial == live.serial;
+            if (!exists || (entity.has<State>() && !entity.get<State>().isAlive))
+                region.consumed[live.spawn] = true;
+            if (!exists)
+                continue;
+
+            if (entity.has<Physics>() && b2Body_IsValid(entity.get<Physics>().body))
+                b2DestroyBody(entity.get<Physics>().body);
+            else if (entity.has<Collider>() && b2Body_IsValid(entity.get<Collider>().body))
+                b2DestroyBody(entity.get<Collider>().body);
+            _doomed.push_back(live.ent);
+        }
+        bagel::World::destroyEntities(_doomed.data(), static_cast<bagel::size_type>(_doomed.size()));
+        region.live.clear();
+        region.loaded = false;
+    }
+
+    void LevelStreamer::spawn(const Spawn& s, const BodyBox& body, int region, int index)
+    {
+        bagel::ent_type e{};
+        switch (s.kind) {
+            case SpawnKind::Enemy:
+                e = createEnemy(s.x, s.y, s.enemy, s.scoreValue);
+                break;
+            case SpawnKind::Block:
+                e = createBlock(s.x, s.y, s.block,
+                                s.collectable != CollectableType::None, 1,
+                                s.block == BlockType::Brick, s.collectable);
+                break;
+            case SpawnKind::Collectable:
+                e = createCollectable(s.x, s.y, s.collectable, s.scoreValue);
+                break;
+        }
+
+        bagel::Entity entity{e};
+        entity.add(Streamed{region, ++_serial});
+        createBody(_world, _boxScale, entity, body);
+        _regions[region].live.push_back({e, _serial, index});
+    }
+}
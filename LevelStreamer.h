@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+
+#include "box2d/box2d.h"
+#include "bagel.h"
+#include "Mario.h"
+#include "LevelTypes.h"
+
+namespace mario {
+
+    class LevelFile;
+
+    /// @brief Streamed component marks an entity owned by a level region.
+    struct Streamed {
+        int region; // Index of the region that spawned the entity
+        unsigned serial; // Distinguishes this entity from later ones that reuse its id
+    };
+
+    /// @brief Spawns the entities of a level region as the camera approaches it,
+    /// and destroys them (with their Box2D bodies) once the camera has left them far behind.
+    ///
+    /// Only regions around the camera are alive at any time, so entity count and
+    /// per-frame system cost do not depend on the length of the level. A spawn whose
+    /// entity was destroyed or died while its region was loaded (a collected coin, a
+    /// killed enemy) is consumed and not spawned again when the region reloads.
+    class LevelStreamer
+    {
+    public:
+        static constexpr float REGION_WIDTH = mario::REGION_WIDTH; // Width of a region in world units
+        static constexpr float TILE_SIZE = LEVEL_TILE_SIZE; // Size of a spawned entity's collision box in world units
+
+        /// @param world Box2D world that receives the bodies of spawned entities.
+        /// @param boxScale Pixels per Box2D unit.
+        /// @param loadAhead Distance ahead of the view at which regions are spawned.
+        /// @param unloadBehind Distance behind the view at which regions are destroyed.
+        LevelStreamer(b2WorldId world, float boxScale,
+                      float loadAhead = DEFAULT_CAMERA_WIDTH / 2.f,
+                      float unloadBehind = DEFAULT_CAMERA_WIDTH);
+        ~LevelStreamer();
+
+        LevelStreamer(const LevelStreamer&) = delete;
+        LevelStreamer& operator=(const LevelStreamer&) = delete;
+
+        /// @brief Adds an entity to the level. It is created the next time its region streams in.
+        void add(const Spawn& spawn);
+
+        /// @brief Streams the spawns of a compiled level in place of added ones.
+        /// The spawns and bodies are read from level's mapping, which must outlive the streamer.
+        void adopt(const LevelFile& level);
+
+        /// @brief Index of the region holding x.
+        static int regionOf(float x) { return mario::regionOf(x); }
+
+        /// @brief Collision box of a spawned entity.
+        static BodyBox bodyOf(const Spawn& s) { return mario::bodyOf(s); }
+
+        /// @brief Spawns regions entering the load window and destroys regions leaving the keep window.
+        void update(const Position& cam, const Camera& camera);
+
+        /// @brief Destroys every entity spawned so far.
+        void unloadAll();
+
+        std::size_t loadedRegions() const { return _loaded.size(); }
+
+        /// @brief Whether the entity of a spawn was used up; spawns are numbered per region,
+        /// adopted ones first.
+        bool consumed(int region, int spawn) const { return _regions[region].consumed[spawn]; }
+
+    private:
+        struct Live {
+            bagel::ent_type ent;
+            unsigned serial;
+            int spawn; // Index of the spawn in its region
+        };
+
+        struct Region {
+            std::vector<Spawn> spawns;
+            const Spawn* adopted = nullptr; // Spawns in a LevelFile mapping, with their bodies
+            const BodyBox* bodies = nullptr;
+            int adoptedCount = 0;
+            std::vector<bool> consumed; // By spawn index
+            std::vector<Live> live;
+            bool loaded = false;
+        };
+
+        void load(int index);
+        void unload(int index);
+        void spawn(const Spawn& s, const BodyBox& body, int region, int index);
+
+        b2WorldId _world;
+        float _boxScale;
+        float _loadAhead, _unloadBehind;
+        unsigned _serial = 0;
+
+        std::vector<Region> _regions;
+        std::vector<int> _loaded;
+        std::vector<bagel::ent_type> _doomed; // Entities of the region being unloaded
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+// Level data shared by the game and the level compiler; depends on nothing but the standard library.
+
+namespace mario {
+
+    static constexpr int LEVEL_TILE_SIZE = 16; // Size of a tile in pixels, both in the sheet and in the world
+    static constexpr std::uint8_t EMPTY_TILE = 0; // Tile id of an empty cell
+    static constexpr float REGION_WIDTH = 256; // Width of a streamed level region in world units
+
+    /// @brief EnemyType enum holds the different types of enemies.
+    enum class EnemyType {
+        Goomba,
+        Koopa,
+        BulletBill,
+        CheepCheep,
+        HammerBro,
+        Bowser,
+    };
+
+    /// @brief BlockType enum holds the different types of blocks.
+    enum class BlockType {
+        Brick,
+        Question,
+        Empty,
+        Solid
+    };
+
+    /// @brief CollectableType enum holds the different types of collectables.
+    enum class CollectableType {
+        Coin,
+        Mushroom,
+        FireFlower,
+        Star,
+        Flag,
+        None
+    };
+
+    /// @brief SpawnKind enum holds the kinds of entities a level can place.
+    enum class SpawnKind {
+        Enemy,
+        Block,
+        Collectable
+    };
+
+    /// @brief Spawn describes one entity placed in a level, created when its region streams in.
+    struct Spawn {
+        SpawnKind kind; // Which factory creates the entity
+        float x = 0, y = 0; // Position of the entity in the game world
+        EnemyType enemy = EnemyType::Goomba; // Used by SpawnKind::Enemy
+        BlockType block = BlockType::Brick; // Used by SpawnKind::Block
+        CollectableType collectable = CollectableType::None; // Used by SpawnKind::Collectable and held by blocks
+        int scoreValue = 0; // Points awarded by enemies and collectables
+    };
+
+    /// @brief BodyBox is an axis-aligned Box2D box in pixels, given by its center and half extents.
+    struct BodyBox {
+        float x, y;
+        float halfWidth, halfHeight;
+    };
+
+    /// @brief TileDef maps a level symbol to a static tile of the sheet.
+    struct TileDef {
+        std::uint8_t symbol; // Tile id in the grid
+        bool solid; // Whether the tile gets a collider
+        std::int16_t srcX, srcY; // Top-left corner of the tile in the sheet
+    };
+
+    /// @brief Index of the level region holding x.
+    inline int regionOf(float x) { return std::max(0, static_cast<int>(x / REGION_WIDTH)); }
+
+    /// @brief Collision box of a spawned entity, one tile in size.
+    inline BodyBox bodyOf(const Spawn& s) {
+        const float half = LEVEL_TILE_SIZE / 2.f;
+        return {s.x + half, s.y + half, half, half};
+    }
+}
@@ -0,0 +1,58 @@
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstdlib>
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define MARIO_MMAP 1
+#endif
+
+namespace mario
+{
+    MappedFile::MappedFile(const char* path)
+    {
+#if defined(MARIO_MMAP)
+        const int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                _data = p;
+                _size = st.st_size;
+            }
+        }
+        close(fd);
+#else
+        std::FILE* file = std::fopen(path, "rb");
+        if (file == nullptr)
+            return;
+        std::fseek(file, 0, SEEK_END);
+        const long size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        if (size > 0) {
+            void* p = std::malloc(size);
+            if (p != nullptr && std::fread(p, 1, size, file) == static_cast<std::size_t>(size)) {
+                _data = p;
+                _size = size;
+            } else {
+                std::free(p);
+            }
+        }
+        std::fclose(file);
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+#if defined(MARIO_MMAP)
+        if (_data != nullptr)
+            munmap(_data, _size);
+#else
+        std::free(_data);
+#endif
+    }
+}
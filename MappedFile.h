@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+
+namespace mario {
+
+    /// @brief A file mapped read-only into memory. Where mmap is unavailable the file
+    /// is read into a heap buffer instead.
+    ///
+    /// The mapping is private and never written, so every process that maps the same
+    /// file shares its pages through the page cache.
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const char* path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool isOpen() const { return _data != nullptr; }
+        const void* data() const { return _data; }
+        std::size_t size() const { return _size; }
+
+    private:
+        void* _data = nullptr;
+        std::size_t _size = 0;
+    };
+}
@@ -1,12 +1,134 @@
 #include "Mario.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include "SDL3/SDL.h"
 #include "box2d/box2d.h"
 #include "bagel.h"
-#include "lib/box2d/src/body.h"
 #include "SDL3_image/SDL_image.h"
+#include "InputQueue.h"
+#include "LevelFile.h"
+#include "LevelStreamer.h"
+#include "PerfOverlay.h"
+#include "Replay.h"
+#include "TextureCache.h"
+#include "Tilemap.h"
 
 namespace mario
 {
+    Mario::Mario(const char* level) : level(level)
+    {
+        if (!SDL_Init(SDL_INIT_VIDEO)) {
+            std::cout << SDL_GetError() << std::endl;
+            return;
+        }
 
-}
\ No newline at end of file
+        if (!SDL_CreateWindowAndRenderer(
+                "Mario", DEFAULT_CAMERA_WIDTH, DEFAULT_CAMERA_HEIGHT, 0, &win, &ren)) {
+            std::cout << SDL_GetError() << std::endl;
+            return;
+        }
+        tex = getTexture(SHEET);
+        if (tex == nullptr) {
+            std::cout << SDL_GetError() << std::endl;
+            return;
+        }
+
+        // World y grows downward, as on screen
+        b2WorldDef worldDef = b2DefaultWorldDef();
+        worldDef.gravity = {0, 10};
+        world = b2CreateWorld(&worldDef);
+    }
+
+    Mario::~Mario()
+    {
+        if (b2World_IsValid(world))
+            b2DestroyWorld(world);
+        if (tex != nullptr)
+            SDL_DestroyTexture(tex);
+        if (ren != nullptr)
+            SDL_DestroyRenderer(ren);
+        if (win != nullptr)
+            SDL_DestroyWindow(win);
+
+        SDL_Quit();
+    }
+
+    SDL_Texture* Mario::getTexture(const char* path)
+    {
+        return TextureCache().load(ren, path);
+    }
+
+    void Mario::run()
+    {
+        if (tex == nullptr)
+            return;
+
+        const LevelFile file(level);
+        if (!file.isOpen()) {
+            std::cout << "Cannot read level " << level << std::endl;
+            return;
+        }
+
+        Tilemap tiles(file.columns(), file.rows(), tex);
+        tiles.load(file);
+        Tilemap::buildColliders(world, BOX_SCALE, file);
+        LevelStreamer streamer(world, BOX_SCALE);
+        streamer.adopt(file);
+
+        // The view shows the full height of the level, stretched over the window
+        const float levelWidth = static_cast<float>(file.columns() * Tilemap::TILE_SIZE);
+        const float levelHeight = static_cast<float>(file.rows() * Tilemap::TILE_SIZE);
+        const bagel::Entity player{createMario(2 * Tilemap::TILE_SIZE, levelHeight - 3 * Tilemap::TILE_SIZE, ren)};
+        const bagel::Entity camera{createCamera(0, 0, levelHeight * DEFAULT_CAMERA_WIDTH / DEFAULT_CAMERA_HEIGHT,
+                                                levelHeight)};
+
+        SDL_SetRenderDrawColor(ren, 92, 148, 252, 255);
+        InputQueue::start();
+        PerfOverlay perf;
+        constexpr float STEP = 1.f / FPS;
+        bool quit = false;
+        while (!quit) {
+            const Uint64 start = SDL_GetTicks();
+            const auto simStart = std::chrono::steady_clock::now();
+
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                if (event.type == SDL_EVENT_QUIT)
+                    quit = true;
+                else if (event.type == SDL_EVENT_RENDER_TARGETS_RESET)
+                    tiles.invalidate();
+            }
+
+            // Keep the player a third of the way into the view
+            const float width = camera.get<Camera>().width;
+            camera.get<Position>().x = std::clamp(player.get<Position>().x - width / 3.f, 0.f,
+                                                  std::max(0.f, levelWidth - width));
+            perf.measure("Streaming", [&] { streamer.update(camera.get<Position>(), camera.get<Camera>()); });
+
+            perf.measure("Input", [] { InputSystem::run(); });
+            ReplayRunner::tick(STEP, world, &perf);
+            const std::chrono::duration<float, std::milli> simMs = std::chrono::steady_clock::now() - simStart;
+            perf.endSim(simMs.count(), world);
+
+            // Spawning may have grown the component storage, so look the camera up only now
+            const Position& cam = camera.get<Position>();
+            const Camera& c = camera.get<Camera>();
+
+            const auto renderStart = std::chrono::steady_clock::now();
+            tiles.bake(ren);
+            SDL_RenderClear(ren);
+            tiles.render(ren, cam, c);
+            RenderSystem::run(ren);
+            perf.draw(ren);
+            SDL_RenderPresent(ren);
+            const std::chrono::duration<float, std::milli> renderMs = std::chrono::steady_clock::now() - renderStart;
+            perf.endRender(renderMs.count());
+
+            const Uint64 elapsed = SDL_GetTicks() - start;
+            if (elapsed < 1000 / FPS)
+                SDL_Delay(static_cast<Uint32>(1000 / FPS - elapsed));
+        }
+        InputQueue::stop();
+    }
+}
@@ -1,32 +1,46 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 #include "SDL3/SDL.h"
 #include "box2d/box2d.h"
 #include "bagel.h"
-#include "lib/box2d/src/body.h"
+#include "InputQueue.h"
+#include "TimingWheel.h"
+#include "LevelTypes.h"
 #include "SDL3_image/SDL_image.h"
 
 namespace mario {
+    /// @brief Plays a compiled level: the static tiles come from the level's grid and are
+    /// drawn as baked chunks, the entities are drawn by RenderSystem on top of them.
     class Mario
     {
     public:
-        Mario();
+        static constexpr const char* DEFAULT_LEVEL = "levels/world1-1.bglv";
+        static constexpr float BOX_SCALE = 10.0f; // World units per Box2D meter
+
+        /// @param level Compiled level file, as built by levelc.
+        explicit Mario(const char* level = DEFAULT_LEVEL);
         ~Mario();
-        SDL_Texture* getTexture(char* path);
+
+        Mario(const Mario&) = delete;
+        Mario& operator=(const Mario&) = delete;
+        SDL_Texture* getTexture(const char* path);
 
         void run();
     private:
         static constexpr int FPS = 60;
-        static constexpr float BOX_SCALE = 10.0f;
         static constexpr float TEX_SCALE = 0.5f;
         static constexpr SDL_FRect BALL_TEX = {404, 580, 76, 76};
+        static constexpr const char* SHEET = "res/World 1-1.png"; // Tiles of the level
 
-        SDL_Texture* tex;
-        SDL_Renderer* ren;
-        SDL_Window* win;
+        const char* level;
+        SDL_Texture* tex = nullptr;
+        SDL_Renderer* ren = nullptr;
+        SDL_Window* win = nullptr;
 
-        b2WorldId world;
+        b2WorldId world = b2_nullWorldId;
     };
 
     /* ================ Components ================ */
@@ -48,8 +62,8 @@ namespace mario {
 
     /// @brief Physics component holds the physics body and shape.
     struct Physics {
-        b2Body* body = nullptr; // Box2D body for physics simulation
-        b2Shape* shape = nullptr; // Shape of the body (e.g., box, circle)
+        b2BodyId body = b2_nullBodyId; // Box2D body for physics simulation
+        b2ShapeId shape = b2_nullShapeId; // Shape of the body (e.g., box, circle)
         float mass = 1.0f; // Mass of the body
     };
 
@@ -68,12 +82,13 @@ namespace mario {
         int frameCount = 0; // Total number of frames
         int currentFrame = 0; // Current frame index
         float frameTime = 0.1f; // Time per frame
+        float elapsed = 0; // Time spent on the current frame
     };
 
     /// @brief Collider component holds the physics body and shape.
     struct Collider {
-        b2Body* body = nullptr; // Box2D body for collision
-        b2Shape* shape = nullptr; // Shape used for collision detection
+        b2BodyId body = b2_nullBodyId; // Box2D body for collision
+        b2ShapeId shape = b2_nullShapeId; // Shape used for collision detection
         bool isTrigger = false; // Whether the collider is a trigger
     };
 
@@ -82,21 +97,15 @@ namespace mario {
         bool up = false, down = false, left = false, right = false; // Movement inputs
         bool jump = false; // Jump input
         bool shoot = false; // Shoot input
+        Uint64 timestamp = 0; // SDL timestamp (ns) of the newest input event applied
     };
 
     /// @brief Camera component holds the camera's dimensions and position.
+    /// The camera entity's Position is the top-left corner of the view in world coordinates.
     struct Camera {
-
-    };
-
-    /// @brief EnemyType enum holds the different types of enemies.
-    enum class EnemyType {
-        Goomba,
-        Koopa,
-        BulletBill,
-        CheepCheep,
-        HammerBro,
-        Bowser,
+        float width = DEFAULT_CAMERA_WIDTH; // Width of the view in world units
+        float height = DEFAULT_CAMERA_HEIGHT; // Height of the view in world units
+        SDL_FRect viewport = {0, 0, DEFAULT_CAMERA_WIDTH, DEFAULT_CAMERA_HEIGHT}; // Screen area the view is drawn into
     };
 
     /// @brief Enemy component holds the type of the enemy.
@@ -126,14 +135,6 @@ namespace mario {
         bool isVisible = true; // Whether the entity is visible
     };
 
-    /// @brief BlockType enum holds the different types of blocks.
-    enum class BlockType {
-        Brick,
-        Question,
-        Empty,
-        Solid
-    };
-
     /// @brief Block component holds the state of a block.
     struct Block {
         BlockType type; // Type of block (e.g., brick, question)
@@ -142,16 +143,6 @@ namespace mario {
         bool isBreakable = true; // Whether the block can be broken
     };
 
-    /// @brief CollectableType enum holds the different types of collectables.
-    enum class CollectableType {
-        Coin,
-        Mushroom,
-        FireFlower,
-        Star,
-        Flag,
-        None
-    };
-
     /// @brief Collectable component holds the type and effect of a collectable.
     struct Collectable {
         CollectableType type; // Type of power-up (e.g., mushroom, fire flower)
@@ -162,11 +153,34 @@ namespace mario {
         int value; // Points awarded when the entity is interacted with
     };
 
-    /// @brief Lifetime component holds the remaining lifetime of the entity.
+    /// @brief Lifetime component holds when the entity expires.
+    /// Add it with LifetimeSystem::add and read the time left with LifetimeSystem::remaining.
     struct Lifetime {
-        float timeRemaining; // Time remaining before the entity is destroyed
+        std::uint64_t expiry; // LifetimeSystem tick at which the entity is destroyed
+        unsigned serial; // Matches the component with its timing wheel entry
     };
 
+    /// @brief Attached component makes an entity follow a parent entity at a fixed offset.
+    /// Change the offset through HierarchySystem::setOffset so the change is propagated, and
+    /// never write the Position of an attached entity directly or give it Movement.
+    struct Attached {
+        bagel::ent_type parent; // Entity this entity follows
+        float dx = 0, dy = 0; // Offset from the parent's position
+
+        // Maintained by HierarchySystem
+        int order = 0; // Depth-first position among attached entities
+        int descendants = 0; // Number of attached entities below this one
+        float px = 0, py = 0; // Parent position used by the last update
+        bool dirty = true; // Offset changed since the last update
+        bool dirtyBelow = false; // Some descendant's offset changed since the last update
+    };
+}
+
+/// Attached components are kept packed and in depth-first order, parents before children.
+template <> struct bagel::Storage<mario::Attached> { using type = bagel::PackedStorage<mario::Attached>; };
+
+namespace mario {
+
     /* ================ Entities ================ */
 
 
@@ -192,41 +206,61 @@ namespace mario {
         return entity.entity();
     }
 
+    /// @brief Component set and default values shared by all enemies.
+    using EnemyPrefab = bagel::Prefab<Position, Enemy, ScoreValue, Movement, Physics,
+                                      Texture, AnimatedImage, Collider, State>;
+
+    inline const EnemyPrefab& enemyPrefab() {
+        static const EnemyPrefab prefab{
+            Position{}, Enemy{EnemyType::Goomba}, ScoreValue{0}, Movement{}, Physics{},
+            Texture{}, AnimatedImage{}, Collider{}, State{}
+        };
+        return prefab;
+    }
+
+    /// @brief Creates a row of Enemy entities in one batch.
+    /// @param out Receives the `count` created entities.
+    /// @param x,y Position of the first enemy in the game world.
+    /// @param spacing Horizontal distance between consecutive enemies.
+    /// @param type Type of the enemies (e.g., Goomba, Koopa).
+    /// @param scoreValue Score value of each enemy.
+    inline void createEnemies(bagel::ent_type* out, int count, float x, float y, float spacing,
+                              EnemyType type, int scoreValue) {
+        enemyPrefab().instantiate(out, count);
+
+        for (int i = 0; i < count; ++i) {
+            bagel::Entity entity{out[i]};
+            entity.get<Position>() = {x + i * spacing, y};
+            entity.get<Enemy>().type = type;
+            entity.get<ScoreValue>().value = scoreValue;
+        }
+    }
+
     /// @brief Creates Enemy entity .
     /// @param x,y Position of the entity in the game world.
     /// @param type Type of the enemy (e.g., Goomba, Koopa).
     inline bagel::ent_type createEnemy(float x, float y, EnemyType type, int scoreValue) {
-        bagel::Entity entity = bagel::Entity::create();
+        bagel::ent_type e;
+        createEnemies(&e, 1, x, y, 0, type, scoreValue);
+        return e;
+    }
 
-        entity.addAll(
-                    Position{x, y},
-                    Enemy{type},
-                    ScoreValue{scoreValue},
-                    Movement{},
-                    Physics{},
-                    Texture{},
-                    AnimatedImage{},
-                    Collider{},
-                    State{}
-                    );
+    /// @brief Component set and default values shared by all projectiles.
+    using ProjectilePrefab = bagel::Prefab<Position, Movement, Physics, Texture, Collider, AnimatedImage>;
 
-        return entity.entity();
+    inline const ProjectilePrefab& projectilePrefab() {
+        static const ProjectilePrefab prefab{
+            Position{}, Movement{}, Physics{}, Texture{}, Collider{}, AnimatedImage{}
+        };
+        return prefab;
     }
 
     /// @brief Creates Projectile entity.
     /// @param x,y Position of the entity in the game world.
     /// @param
     inline bagel::ent_type createProjectile(float x, float y) {
-        bagel::Entity entity = bagel::Entity::create();
-
-        entity.addAll(
-                    Position{x, y},
-                    Movement{},
-                    Physics{},
-                    Texture{},
-                    Collider{},
-                    AnimatedImage{}
-                    );
+        bagel::Entity entity = projectilePrefab().instantiate();
+        entity.get<Position>() = {x, y};
 
         return entity.entity();
     }
@@ -258,6 +292,32 @@ namespace mario {
         return entity.entity();
     }
 
+    /// @brief Component set and default values shared by all coins.
+    using CoinPrefab = bagel::Prefab<Position, Collectable, Texture, AnimatedImage, ScoreValue, Collider, State>;
+
+    inline const CoinPrefab& coinPrefab() {
+        static const CoinPrefab prefab{
+            Position{}, Collectable{CollectableType::Coin}, Texture{}, AnimatedImage{},
+            ScoreValue{0}, Collider{b2_nullBodyId, b2_nullShapeId, true}, State{}
+        };
+        return prefab;
+    }
+
+    /// @brief Creates a row of coin Collectable entities in one batch.
+    /// @param out Receives the `count` created entities.
+    /// @param x,y Position of the first coin in the game world.
+    /// @param spacing Horizontal distance between consecutive coins.
+    /// @param scoreValue Score value of each coin.
+    inline void createCoins(bagel::ent_type* out, int count, float x, float y, float spacing, int scoreValue = 0) {
+        coinPrefab().instantiate(out, count);
+
+        for (int i = 0; i < count; ++i) {
+            bagel::Entity entity{out[i]};
+            entity.get<Position>() = {x + i * spacing, y};
+            entity.get<ScoreValue>().value = scoreValue;
+        }
+    }
+
     /// @brief Creates Block entity.
     /// @param x,y Position of the entity in the game world.
     /// @param type Type of block (e.g., Brick, Question).
@@ -317,14 +377,16 @@ namespace mario {
 
     /// @brief Creates a Camera entity.
     /// @param x,y Position of the camera in the game world.
+    /// @param width,height Size of the camera view in world units.
     /// @return A `bagel::Entity` representing the camera with position, movement, and camera components.
-    inline bagel::ent_type createCamera(float x, float y) {
+    inline bagel::ent_type createCamera(float x, float y,
+                                        float width = DEFAULT_CAMERA_WIDTH, float height = DEFAULT_CAMERA_HEIGHT) {
         bagel::Entity entity = bagel::Entity::create();
 
         entity.addAll(
             Position{x, y},
             Movement{},
-            Camera{}
+            Camera{width, height}
         );
 
         return entity.entity();
@@ -336,208 +398,710 @@ namespace mario {
     class MovemntSystem final: bagel::NoInstance
     {
     public:
+        using Components = bagel::Components<Position, Physics, Movement>;
+        static constexpr bool Parallel = true;
+
+        static void run() { bagel::Pipeline<MovemntSystem>::run(); }
+
+        static void each(bagel::ent_type e) {
+            bagel::Entity entity{e};
+            Position& pos = entity.get<Position>();
+            const Movement& mov = entity.get<Movement>();
+            pos.x += mov.vx;
+            pos.y += mov.vy;
+        }
+    };
+
+    /// @brief Builds the list of visible entities with Position and Texture components for every camera.
+    ///
+    /// Sprites are bucketed into cells of CELL_WIDTH world units by their left edge, so a
+    /// run visits only the cells that overlap a view and off-screen sprites cost nothing.
+    /// New sprites are bucketed as they join the sprite query; sprites that hold Movement
+    /// or Attached are rebucketed every run. Call moved() after placing any other sprite
+    /// somewhere else.
+    class CullingSystem final: bagel::NoInstance
+    {
+    public:
+        static constexpr float CELL_WIDTH = REGION_WIDTH; // Width of a bucket in world units
+
+        /// @brief Entities that intersect the view of a single camera.
+        struct View {
+            bagel::ent_type camera;
+            std::vector<bagel::ent_type> visible;
+        };
+
         static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
-                }
+            std::size_t count = 0;
+            cameras().forEach([&](bagel::ent_type e) {
+                if (count == _views.size())
+                    _views.emplace_back();
+                _views[count].camera = e;
+                _views[count].visible.clear();
+                ++count;
+            });
+            _views.resize(count);
+
+            if (!_tracking) {
+                sprites().trackAdded();
+                _tracking = true;
+            }
+            sprites().takeAdded(place);
+            movers().forEach(place);
+            attached().forEach(place);
+
+            for (View& view : _views) {
+                const Position& cam = bagel::World::getComponent<Position>(view.camera);
+                const Camera& c = bagel::World::getComponent<Camera>(view.camera);
+                const int last = std::min(cellOf(cam.x + c.width), static_cast<int>(_cells.size()) - 1);
+                for (int cell = cellOf(cam.x - _maxWidth); cell <= last; ++cell)
+                    cull(cell, cam, c, view.visible);
             }
         }
+
+        /// @brief Rebuckets e after its Position changed outside MovemntSystem and HierarchySystem.
+        static void moved(bagel::ent_type e) { place(e); }
+
+        /// @brief Views produced by the last run, one per camera entity.
+        static const std::vector<View>& views() { return _views; }
     private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<Position>()
-                            .set<Physics>()
-                            .set<Movement>()
-                            .build();
+        struct Slot {
+            int cell = -1; // Bucket holding the entity, -1 if none
+            int index = 0; // Position in that bucket
+        };
+
+        static int cellOf(float x) { return std::max(0, static_cast<int>(x / CELL_WIDTH)); }
+
+        static float width(const Texture& tex) { return static_cast<float>(tex.dst.w ? tex.dst.w : tex.src.w); }
+        static float height(const Texture& tex) { return static_cast<float>(tex.dst.h ? tex.dst.h : tex.src.h); }
+
+        static bool isSprite(bagel::ent_type e) {
+            const bagel::Entity entity{e};
+            return entity.has<Position>() && entity.has<Texture>();
+        }
+
+        // Moves e to the bucket of its current position, or drops it if it is no longer a sprite
+        static void place(bagel::ent_type e) {
+            if (static_cast<std::size_t>(e.id) >= _slots.size())
+                _slots.resize(e.id + 1);
+            if (!isSprite(e)) {
+                remove(e);
+                return;
+            }
+
+            const bagel::Entity entity{e};
+            const int cell = cellOf(entity.get<Position>().x);
+            _maxWidth = std::max(_maxWidth, width(entity.get<Texture>()));
+            if (_slots[e.id].cell == cell)
+                return;
+
+            remove(e);
+            if (cell >= static_cast<int>(_cells.size()))
+                _cells.resize(cell + 1);
+            _slots[e.id] = {cell, static_cast<int>(_cells[cell].size())};
+            _cells[cell].push_back(e);
+        }
+
+        static void remove(bagel::ent_type e) {
+            Slot& slot = _slots[e.id];
+            if (slot.cell < 0)
+                return;
+            std::vector<bagel::ent_type>& bucket = _cells[slot.cell];
+            bucket[slot.index] = bucket.back();
+            _slots[bucket[slot.index].id].index = slot.index;
+            bucket.pop_back();
+            slot.cell = -1;
+        }
+
+        // Adds the sprites of a cell that intersect the view; drops destroyed ones on the way
+        static void cull(int cell, const Position& cam, const Camera& c, std::vector<bagel::ent_type>& visible) {
+            std::vector<bagel::ent_type>& bucket = _cells[cell];
+            for (std::size_t i = 0; i < bucket.size();) {
+                const bagel::ent_type e = bucket[i];
+                if (!isSprite(e)) {
+                    remove(e);
+                    continue;
+                }
+
+                const bagel::Entity entity{e};
+                const Position& pos = entity.get<Position>();
+                const Texture& tex = entity.get<Texture>();
+                if (pos.x < cam.x + c.width && pos.x + width(tex) > cam.x &&
+                    pos.y < cam.y + c.height && pos.y + height(tex) > cam.y)
+                    visible.push_back(e);
+                ++i;
+            }
+        }
+
+        static bagel::Query<Position, Camera>& cameras() {
+            static bagel::Query<Position, Camera> q;
+            return q;
+        }
+        static bagel::Query<Position, Texture>& sprites() {
+            static bagel::Query<Position, Texture> q;
+            return q;
+        }
+        static bagel::Query<Position, Texture, Movement>& movers() {
+            static bagel::Query<Position, Texture, Movement> q;
+            return q;
+        }
+        static bagel::Query<Position, Texture, Attached>& attached() {
+            static bagel::Query<Position, Texture, Attached> q;
+            return q;
+        }
+
+        static inline std::vector<View> _views;
+        static inline std::vector<std::vector<bagel::ent_type>> _cells; // Sprites by cell of their left edge
+        static inline std::vector<Slot> _slots; // By entity id
+        static inline float _maxWidth = 0; // Widest sprite seen, how far left of a view sprites may start
+        static inline bool _tracking = false;
     };
 
-    /// @brief Renders entities with Position and Texture components.
+    /// @brief Renders the entities CullingSystem found visible, once per camera.
     class RenderSystem final: bagel::NoInstance
     {
     public:
-        static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
+        static void run(SDL_Renderer* renderer) {
+            for (const CullingSystem::View& view : CullingSystem::views()) {
+                const Position& cam = bagel::World::getComponent<Position>(view.camera);
+                const Camera& c = bagel::World::getComponent<Camera>(view.camera);
+                const float sx = c.viewport.w / c.width;
+                const float sy = c.viewport.h / c.height;
+
+                for (bagel::ent_type e : view.visible) {
+                    bagel::Entity entity{e};
+                    const Position& pos = entity.get<Position>();
+                    const Texture& tex = entity.get<Texture>();
+                    const float w = static_cast<float>(tex.dst.w ? tex.dst.w : tex.src.w);
+                    const float h = static_cast<float>(tex.dst.h ? tex.dst.h : tex.src.h);
+
+                    const SDL_FRect src = {
+                        static_cast<float>(tex.src.x), static_cast<float>(tex.src.y),
+                        static_cast<float>(tex.src.w), static_cast<float>(tex.src.h)
+                    };
+                    const SDL_FRect dst = {
+                        c.viewport.x + (pos.x - cam.x) * sx,
+                        c.viewport.y + (pos.y - cam.y) * sy,
+                        w * sx, h * sy
+                    };
+                    SDL_RenderTexture(renderer, tex.texture, tex.src.w ? &src : nullptr, &dst);
                 }
             }
         }
-    private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<Position>()
-                            .set<Texture>()
-                            .build();
     };
 
     /// @brief Processes input for entities with the Input component.
+    /// Drains the events InputQueue sampled since the last tick in one batch.
     class InputSystem final: bagel::NoInstance
     {
     public:
         static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
-                }
+            if (InputQueue::events().drain(apply) == 0)
+                return;
+
+            query().forEach([](bagel::ent_type e) {
+                bagel::World::getComponent<Input>(e) = _state;
+            });
+        }
+
+        /// @brief Applies one key change to the sampled input state.
+        static void apply(const InputEvent& event) {
+            switch (event.scancode) {
+                case SDL_SCANCODE_UP: case SDL_SCANCODE_W: _state.up = event.down; break;
+                case SDL_SCANCODE_DOWN: case SDL_SCANCODE_S: _state.down = event.down; break;
+                case SDL_SCANCODE_LEFT: case SDL_SCANCODE_A: _state.left = event.down; break;
+                case SDL_SCANCODE_RIGHT: case SDL_SCANCODE_D: _state.right = event.down; break;
+                case SDL_SCANCODE_SPACE: case SDL_SCANCODE_Z: _state.jump = event.down; break;
+                case SDL_SCANCODE_LCTRL: case SDL_SCANCODE_X: _state.shoot = event.down; break;
+                default: return;
             }
+            _state.timestamp = event.timestamp;
+        }
+
+        static const Input& state() { return _state; }
+
+        /// @brief Replaces the sampled state, e.g. with recorded input, and applies it.
+        static void inject(const Input& input) {
+            _state = input;
+            query().forEach([](bagel::ent_type e) {
+                bagel::World::getComponent<Input>(e) = _state;
+            });
         }
     private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<Input>()
-                            .build();
+        static bagel::Query<Input>& query() {
+            static bagel::Query<Input> q;
+            return q;
+        }
+
+        static inline Input _state;
     };
 
     /// @brief Handles player control by processing Input, Movement, and State components.
     class PlayerControlSystem final: bagel::NoInstance
     {
     public:
-        static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
-                }
+        static constexpr float WALK_SPEED = 2.0f; // Horizontal speed while a direction is held
+        static constexpr float JUMP_SPEED = 6.0f; // Upward speed when a jump starts
+
+        using Components = bagel::Components<Input, Movement, State>;
+        static constexpr bool Parallel = true;
+
+        static void run() { bagel::Pipeline<PlayerControlSystem>::run(); }
+
+        static void each(bagel::ent_type e) {
+            bagel::Entity entity{e};
+            const Input& input = entity.get<Input>();
+            Movement& mov = entity.get<Movement>();
+            State& state = entity.get<State>();
+
+            mov.vx = (static_cast<float>(input.right) - static_cast<float>(input.left)) * WALK_SPEED;
+            state.isWalking = mov.vx != 0;
+            if (input.jump && state.isOnGround) {
+                mov.vy = -JUMP_SPEED;
+                state.isOnGround = false;
             }
         }
-    private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<Input>()
-                            .set<Movement>()
-                            .set<State>()
-                            .build();
     };
 
-    /// @brief Manages collision detection and response for entities with Position, Collider, and ScoreValue components.
+    /// @brief Destroys entity together with the Box2D body of its collider.
+    inline void destroyWithBody(bagel::Entity entity) {
+        if (entity.has<Collider>() && b2Body_IsValid(entity.get<Collider>().body))
+            b2DestroyBody(entity.get<Collider>().body);
+        entity.destroy();
+    }
+
+    /// @brief CollisionPair holds two entities whose shapes started touching in the last physics step.
+    struct CollisionPair {
+        bagel::ent_type a, b; // For sensor pairs, a is the sensor and b the visiting entity
+        bool sensor; // Whether the pair comes from a trigger collider
+    };
+
+    /// @brief Turns Box2D begin-touch and sensor events into per-frame entity pairs.
+    ///
+    /// Shapes carry their entity in the user data, so the cost of a frame is proportional to
+    /// the number of new contacts rather than to the number of colliders. Score, PowerUps and
+    /// Death read pairs() instead of testing entities against each other.
     class CollisionSystem final: bagel::NoInstance
     {
     public:
-        static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
-                }
+        /// @brief Shape user data that identifies e; 0 is reserved for shapes without an entity.
+        static void* userData(bagel::ent_type e) {
+            return reinterpret_cast<void*>(static_cast<std::intptr_t>(e.id) + 1);
+        }
+
+        /// @brief Shape definition for an entity's collider; triggers become Box2D sensors.
+        static b2ShapeDef shapeDef(bagel::ent_type e, const Collider& collider) {
+            b2ShapeDef def = b2DefaultShapeDef();
+            def.userData = userData(e);
+            def.isSensor = collider.isTrigger;
+            def.enableSensorEvents = true;
+            def.enableContactEvents = true;
+            return def;
+        }
+
+        /// @brief Collects the pairs reported by the last step of world.
+        static void run(b2WorldId world) {
+            _pairs.clear();
+
+            const b2ContactEvents contacts = b2World_GetContactEvents(world);
+            for (int i = 0; i < contacts.beginCount; ++i) {
+                const b2ContactBeginTouchEvent& ev = contacts.beginEvents[i];
+                push(ev.shapeIdA, ev.shapeIdB, false);
+            }
+
+            const b2SensorEvents sensors = b2World_GetSensorEvents(world);
+            for (int i = 0; i < sensors.beginCount; ++i) {
+                const b2SensorBeginTouchEvent& ev = sensors.beginEvents[i];
+                push(ev.sensorShapeId, ev.visitorShapeId, true);
             }
         }
+
+        /// @brief Pairs found by the last run, valid until the next one.
+        static const std::vector<CollisionPair>& pairs() { return _pairs; }
+
     private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<Position>()
-                            .set<Physics>()
-                            .set<Collider>()
-                            .set<ScoreValue>()
-                            .build();
+        static void push(b2ShapeId a, b2ShapeId b, bool sensor) {
+            // Shapes may have been destroyed since the step that reported them
+            if (!b2Shape_IsValid(a) || !b2Shape_IsValid(b))
+                return;
+            const auto ida = reinterpret_cast<std::intptr_t>(b2Shape_GetUserData(a));
+            const auto idb = reinterpret_cast<std::intptr_t>(b2Shape_GetUserData(b));
+            if (ida == 0 || idb == 0)
+                return;
+            _pairs.push_back({{static_cast<bagel::id_type>(ida - 1)},
+                              {static_cast<bagel::id_type>(idb - 1)}, sensor});
+        }
+
+        static inline std::vector<CollisionPair> _pairs;
     };
 
-    /// @brief Applies power-ups to entities with Collider and Collectable components.
+    /// @brief Gives the collider of entity a Box2D body in world, a dynamic one if it also
+    /// holds Physics. box is in world units, Box2D lengths are those divided by boxScale.
+    inline void createBody(b2WorldId world, float boxScale, bagel::Entity entity, const BodyBox& box) {
+        if (!entity.has<Collider>())
+            return;
+
+        b2BodyDef bodyDef = b2DefaultBodyDef();
+        bodyDef.type = entity.has<Physics>() ? b2_dynamicBody : b2_staticBody;
+        bodyDef.position = {box.x / boxScale, box.y / boxScale};
+        bodyDef.fixedRotation = true;
+        bodyDef.userData = CollisionSystem::userData(entity.entity());
+        b2BodyId body = b2CreateBody(world, &bodyDef);
+
+        Collider& collider = entity.get<Collider>();
+        b2ShapeDef shapeDef = CollisionSystem::shapeDef(entity.entity(), collider);
+        b2Polygon polygon = b2MakeBox(box.halfWidth / boxScale, box.halfHeight / boxScale);
+        b2ShapeId shape = b2CreatePolygonShape(body, &shapeDef, &polygon);
+
+        collider.body = body;
+        collider.shape = shape;
+        if (entity.has<Physics>()) {
+            Physics& physics = entity.get<Physics>();
+            physics.body = body;
+            physics.shape = shape;
+        }
+    }
+
+    /// @brief Visits the pairs in which the player (the entity with Input) touched an entity
+    /// holding all of Ts, calling f(player, other).
+    template <class ...Ts, class F>
+    void forEachPlayerHit(F&& f) {
+        for (const CollisionPair& pair : CollisionSystem::pairs()) {
+            bagel::Entity a{pair.a}, b{pair.b};
+            if (a.has<Input>() && (b.has<Ts>() && ...))
+                f(a, b);
+            else if (b.has<Input>() && (a.has<Ts>() && ...))
+                f(b, a);
+        }
+    }
+
+    /// @brief Applies power-ups the player touched and marks them as collected.
     class PowerUpsSystem final: bagel::NoInstance
     {
     public:
         static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
+            forEachPlayerHit<Collectable, State>([](bagel::Entity player, bagel::Entity item) {
+                State& state = item.get<State>();
+                if (!state.isAlive)
+                    return;
+                state.isAlive = false;
+
+                if (!player.has<MarioState>())
+                    return;
+                MarioState& mario = player.get<MarioState>();
+                switch (item.get<Collectable>().type) {
+                    case CollectableType::Mushroom:
+                        mario.isBigMario = true;
+                        break;
+                    case CollectableType::FireFlower:
+                        mario.isBigMario = true;
+                        mario.isFireMario = true;
+                        break;
+                    case CollectableType::Star:
+                        mario.isSuperMario = true;
+                        break;
+                    default:
+                        break;
                 }
-            }
+            });
         }
-    private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<Collider>()
-                            .set<Collectable>()
-                            .build();
     };
 
     /// @brief Updates animations for entities with State and AnimatedImage components.
     class AnimationSystem final: bagel::NoInstance
     {
     public:
-        static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
-                }
+        using Components = bagel::Components<State, AnimatedImage>;
+        static constexpr bool Parallel = true;
+
+        /// @param dt Time elapsed since the last run, in seconds.
+        static void run(float dt) { bagel::Pipeline<AnimationSystem>::run(dt); }
+
+        static void each(bagel::ent_type e, float dt) {
+            bagel::Entity entity{e};
+            const State& state = entity.get<State>();
+            AnimatedImage& anim = entity.get<AnimatedImage>();
+            if (!state.isVisible || anim.frameCount == 0)
+                return;
+
+            anim.elapsed += dt;
+            while (anim.elapsed >= anim.frameTime) {
+                anim.elapsed -= anim.frameTime;
+                anim.currentFrame = (anim.currentFrame + 1) % anim.frameCount;
             }
         }
-    private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<State>()
-                            .set<AnimatedImage>()
-                            .build();
     };
 
-    /// @brief Updates the score for entities with the ScoreValue component.
+    /// @brief Adds the value of collectables and enemies the player finished this frame to the score.
     class ScoreSystem final: bagel::NoInstance
     {
     public:
         static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
-                }
-            }
+            forEachPlayerHit<ScoreValue, State>([](bagel::Entity, bagel::Entity other) {
+                if (!other.get<State>().isAlive)
+                    _score += other.get<ScoreValue>().value;
+            });
         }
+
+        static int score() { return _score; }
+        static void reset() { _score = 0; }
+
     private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<ScoreValue>()
-                            .build();
+        static inline int _score = 0;
     };
 
-    /// @brief Handles the destruction of entities with the State component when they are no longer alive.
+    /// @brief Resolves player/enemy contacts and destroys the entities that died this frame.
+    /// run() only marks entities as dead so ScoreSystem can still read them; sweep() destroys them.
     class DeathSystem final: bagel::NoInstance
     {
     public:
         static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
+            forEachPlayerHit<Enemy, State>([](bagel::Entity player, bagel::Entity enemy) {
+                State& enemyState = enemy.get<State>();
+                if (!enemyState.isAlive || !player.get<State>().isAlive)
+                    return;
+
+                // Invincible or falling onto the enemy kills it; anything else hurts the player
+                const bool stomp = player.has<Movement>() && player.get<Movement>().vy > 0;
+                if (stomp || (player.has<MarioState>() && player.get<MarioState>().isSuperMario)) {
+                    enemyState.isAlive = false;
+                } else if (player.has<MarioState>() && player.get<MarioState>().isBigMario) {
+                    player.get<MarioState>() = MarioState{};
+                } else {
+                    player.get<State>().isAlive = false;
                 }
+            });
+        }
+
+        /// @brief Destroys the dead entities of this frame's pairs, together with their bodies.
+        /// The player is kept so the game can restart.
+        static void sweep() {
+            for (const CollisionPair& pair : CollisionSystem::pairs()) {
+                destroyIfDead(pair.a);
+                destroyIfDead(pair.b);
             }
         }
+
     private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<State>()
-                            .build();
+        static void destroyIfDead(bagel::ent_type e) {
+            bagel::Entity entity{e};
+            if (entity.has<State>() && !entity.get<State>().isAlive && !entity.has<Input>())
+                destroyWithBody(entity);
+        }
     };
 
-    /// @brief Updates the camera position based on entities with Position and Camera components.
-    class CameraSystem final: bagel::NoInstance
+    /// @brief Moves attached entities with their parents.
+    ///
+    /// Attached components are stored in depth-first order, so one linear pass
+    /// visits every parent before its children. Subtrees whose root and parent did not
+    /// move and hold no changed offsets are skipped whole. The skip trusts that only this
+    /// system positions attached entities: move a tree through its root, which is not
+    /// attached, and its members through setOffset. A Position written straight to an
+    /// attached entity is not seen by its children and is replaced once its parent moves.
+    class HierarchySystem final: bagel::NoInstance
     {
     public:
+        using Links = bagel::Storage<Attached>::type;
+
+        /// @brief Attaches child to parent at offset dx,dy from the parent's position.
+        static void attach(bagel::ent_type child, bagel::ent_type parent, float dx, float dy) {
+            if (Links::has(child)) {
+                Attached& link = Links::get(child);
+                link.parent = parent;
+                link.dx = dx;
+                link.dy = dy;
+                link.dirty = true;
+            } else {
+                bagel::World::addComponent(child, Attached{parent, dx, dy});
+            }
+            _reorder = true;
+        }
+
+        /// @brief Detaches child; its own children stay attached to it.
+        static void detach(bagel::ent_type child) {
+            bagel::World::delComponent<Attached>(child);
+            _reorder = true;
+        }
+
+        /// @brief Changes the offset of an attached entity from its parent.
+        static void setOffset(bagel::ent_type child, float dx, float dy) {
+            Attached& link = Links::get(child);
+            link.dx = dx;
+            link.dy = dy;
+            link.dirty = true;
+
+            for (bagel::ent_type p = link.parent; Links::has(p);) {
+                Attached& up = Links::get(p);
+                if (up.dirtyBelow)
+                    break;
+                up.dirtyBelow = true;
+                p = up.parent;
+            }
+        }
+
         static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
+            // Destroying a linked entity drops its slot and breaks the depth-first order
+            const bool full = _reorder || Links::size() != _linked;
+            if (full)
+                reorder();
+
+            for (int i = 0; i < Links::size(); ++i) {
+                Attached& link = Links::get(i);
+                bagel::Entity parent{link.parent};
+                if (!parent.has<Position>())
+                    continue;
+
+                const Position& pp = parent.get<Position>();
+                const bool moved = link.dirty || pp.x != link.px || pp.y != link.py;
+                if (!moved && !link.dirtyBelow && !full) {
+                    i += link.descendants;
+                    continue;
+                }
+
+                if (moved) {
+                    Position& pos = bagel::World::getComponent<Position>(Links::entity(i));
+                    pos.x = pp.x + link.dx;
+                    pos.y = pp.y + link.dy;
+                    link.px = pp.x;
+                    link.py = pp.y;
+                    link.dirty = false;
                 }
+                link.dirtyBelow = false;
             }
         }
+
     private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<Position>()
-                            .set<Camera>()
-                            .build();
+        // Numbers the attached entities depth-first from the roots, then sorts the packed storage by it
+        static void reorder() {
+            _reorder = false;
+            const int n = Links::size();
+            _linked = n;
+            _first.assign(n, -1);
+            _next.assign(n, -1);
+            _stack.clear();
+
+            for (int i = n - 1; i >= 0; --i) {
+                Links::get(i).order = -1;
+                const bagel::ent_type parent = Links::get(i).parent;
+                if (Links::has(parent) && bagel::Entity{parent}.has<Attached>()) {
+                    const int p = Links::index(parent);
+                    _next[i] = _first[p];
+                    _first[p] = i;
+                } else {
+                    _stack.push_back(i);
+                }
+            }
+
+            int order = 0;
+            while (!_stack.empty()) {
+                const int i = _stack.back();
+                if (i < 0) {
+                    // Leaving a node: everything numbered since it is below it
+                    Attached& link = Links::get(~i);
+                    link.descendants = order - link.order - 1;
+                    _stack.pop_back();
+                    continue;
+                }
+
+                Attached& link = Links::get(i);
+                link.order = order++;
+                _stack.back() = ~i;
+                for (int c = _first[i]; c != -1; c = _next[c])
+                    _stack.push_back(c);
+            }
+
+            // Entities attached in a cycle are unreachable from any root; keep them last
+            for (int i = 0; i < n; ++i) {
+                Attached& link = Links::get(i);
+                if (link.order < 0) {
+                    link.order = order++;
+                    link.descendants = 0;
+                }
+            }
+
+            bagel::World::sort<Attached>([](const Attached& a, const Attached& b) {
+                return a.order < b.order;
+            });
+        }
+
+        static inline bool _reorder = false;
+        static inline int _linked = 0; // Links::size() at the last reorder
+        static inline std::vector<int> _first, _next, _stack;
+    };
+
+    /// @brief Updates the camera position based on entities with Position and Camera components.
+    class CameraSystem final: bagel::NoInstance
+    {
+    public:
+        using Components = bagel::Components<Position, Camera>;
+
+        static void run() { bagel::Pipeline<CameraSystem>::run(); }
+
+        static void each(bagel::ent_type) {
+            // Process the entity
+        }
     };
 
     /// @brief Destroys entities with the Lifetime component when their lifetime expires.
+    ///
+    /// Expiries live in a timing wheel, so a tick only touches the entities due on it.
+    /// An entry is honoured only while its entity still holds the Lifetime it was scheduled
+    /// with; removing the component or destroying the entity cancels it.
     class LifetimeSystem final: bagel::NoInstance
     {
     public:
-        static void run() {
-            for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-                bagel::Entity entity{e};
-                if (entity.test(mask)) {
-                    // Process the entity
-                }
+        static constexpr float TICK = 1.f / 60.f; // Resolution of lifetimes in seconds
+
+        /// @brief Gives e a lifetime of seconds, replacing any previous one.
+        static void add(bagel::ent_type e, float seconds) {
+            const auto ticks = static_cast<std::uint64_t>(seconds / TICK + 0.5f);
+            const Lifetime lifetime{_wheel.now() + (ticks > 0 ? ticks : 1), ++_serial};
+            bagel::Entity entity{e};
+            if (entity.has<Lifetime>())
+                entity.get<Lifetime>() = lifetime;
+            else
+                entity.add(lifetime);
+            _wheel.schedule(lifetime.expiry, {e, lifetime.serial});
+        }
+
+        /// @brief Removes the lifetime of e so it is not destroyed.
+        static void cancel(bagel::ent_type e) {
+            bagel::World::delComponent<Lifetime>(e);
+        }
+
+        /// @brief Seconds until e expires.
+        static float remaining(bagel::ent_type e) {
+            const Lifetime& lifetime = bagel::World::getComponent<Lifetime>(e);
+            const float left = static_cast<float>(lifetime.expiry - _wheel.now()) * TICK - _elapsed;
+            return left > 0 ? left : 0;
+        }
+
+        /// @param dt Time elapsed since the last run, in seconds.
+        static void run(float dt) {
+            _elapsed += dt;
+            while (_elapsed >= TICK) {
+                _elapsed -= TICK;
+                _wheel.advance([](const Scheduled& s) {
+                    bagel::Entity entity{s.entity};
+                    if (entity.has<Lifetime>() && entity.get<Lifetime>().serial == s.serial)
+                        destroyWithBody(entity);
+                });
             }
         }
+
+        /// @brief Forgets every scheduled expiry; call after bagel::World::reset.
+        static void reset() {
+            _wheel.clear();
+            _elapsed = 0;
+        }
+
     private:
-        static inline bagel::Mask mask = bagel::MaskBuilder()
-                            .set<Lifetime>()
-                            .build();
+        struct Scheduled {
+            bagel::ent_type entity;
+            unsigned serial;
+        };
+
+        static inline TimingWheel<Scheduled> _wheel;
+        static inline float _elapsed = 0; // Time accumulated toward the next tick
+        static inline unsigned _serial = 0;
     };
 }
@@ -0,0 +1,128 @@
+#include "PerfOverlay.h"
+#include <algorithm>
+#include <cstdio>
+#include "bagel.h"
+
+namespace mario
+{
+    namespace {
+        constexpr float X = 8, Y = 8; // Top-left corner of the panel
+        constexpr float GRAPH_H = 60;
+        constexpr float GRAPH_MS = 33.3f; // Frame time at the top of the graph
+        constexpr float LINE_H = 10; // SDL debug font is 8 pixels high
+        constexpr float WIDTH = PerfOverlay::HISTORY * 2;
+    }
+
+    PerfOverlay::PerfOverlay()
+    {
+        SDL_AddEventWatch(&PerfOverlay::watch, this);
+    }
+
+    PerfOverlay::~PerfOverlay()
+    {
+        SDL_RemoveEventWatch(&PerfOverlay::watch, this);
+    }
+
+    bool PerfOverlay::watch(void* userdata, SDL_Event* event)
+    {
+        if (event->type == SDL_EVENT_KEY_DOWN && !event->key.repeat && event->key.scancode == TOGGLE_KEY) {
+            auto* overlay = static_cast<PerfOverlay*>(userdata);
+            overlay->_visible.store(!overlay->visible(), std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    void PerfOverlay::charge(const char* name, float ms)
+    {
+        for (int i = 0; i < _pendingCount; ++i) {
+            if (_pending[i].name == name) {
+                _pending[i].ms += ms;
+                return;
+            }
+        }
+        if (_pendingCount < MAX_SYSTEMS)
+            _pending[_pendingCount++] = {name, ms};
+    }
+
+    void PerfOverlay::endSim(float simMs)
+    {
+        publish(simMs, 0);
+    }
+
+    void PerfOverlay::endSim(float simMs, b2WorldId world)
+    {
+        publish(simMs, b2World_GetProfile(world).step);
+    }
+
+    void PerfOverlay::publish(float simMs, float physicsMs)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sim[_frame] = simMs;
+        _render[_frame] = 0;
+        _frame = (_frame + 1) % HISTORY;
+        for (int i = 0; i < _pendingCount; ++i) {
+            _systems[i] = _pending[i];
+            _pending[i].ms = 0;
+        }
+        _systemCount = _pendingCount;
+        _physicsMs = physicsMs;
+        _entities = bagel::World::entities();
+    }
+
+    void PerfOverlay::endRender(float renderMs)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _render[(_frame + HISTORY - 1) % HISTORY] = renderMs;
+    }
+
+    void PerfOverlay::draw(SDL_Renderer* ren)
+    {
+        if (!visible())
+            return;
+
+        SDL_FPoint sim[HISTORY], total[HISTORY];
+        char text[MAX_SYSTEMS + 3][64];
+        int lines = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            float worst = 0, sum = 0;
+            for (int i = 0; i < HISTORY; ++i) {
+                // Oldest frame first, one frame every 2 pixels
+                const int f = (_frame + i) % HISTORY;
+                const float t = _sim[f] + _render[f];
+                const float x = X + 2.f * i;
+                sim[i] = {x, Y + GRAPH_H - std::min(_sim[f], GRAPH_MS) * (GRAPH_H / GRAPH_MS)};
+                total[i] = {x, Y + GRAPH_H - std::min(t, GRAPH_MS) * (GRAPH_H / GRAPH_MS)};
+                worst = std::max(worst, t);
+                sum += t;
+            }
+            const int last = (_frame + HISTORY - 1) % HISTORY;
+            std::snprintf(text[lines++], sizeof(text[0]), "frame %.2f avg %.2f max %.2f ms",
+                          _sim[last] + _render[last], sum / HISTORY, worst);
+            std::snprintf(text[lines++], sizeof(text[0]), "sim %.2f render %.2f box2d %.2f ms",
+                          _sim[last], _render[last], _physicsMs);
+            std::snprintf(text[lines++], sizeof(text[0]), "entities %d", _entities);
+            for (int i = 0; i < _systemCount; ++i)
+                std::snprintf(text[lines++], sizeof(text[0]), "  %-18s %.3f ms", _systems[i].name, _systems[i].ms);
+        }
+
+        Uint8 r, g, b, a;
+        SDL_GetRenderDrawColor(ren, &r, &g, &b, &a);
+
+        const SDL_FRect panel = {X - 4, Y - 4, WIDTH + 8, GRAPH_H + 8 + lines * LINE_H};
+        SDL_SetRenderDrawColor(ren, 16, 16, 16, 255);
+        SDL_RenderFillRect(ren, &panel);
+
+        // Total frame time in white over the simulation share in green
+        SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
+        SDL_RenderLines(ren, total, HISTORY);
+        SDL_SetRenderDrawColor(ren, 64, 224, 64, 255);
+        SDL_RenderLines(ren, sim, HISTORY);
+
+        SDL_SetRenderDrawColor(ren, 224, 224, 224, 255);
+        for (int i = 0; i < lines; ++i)
+            SDL_RenderDebugText(ren, X, Y + GRAPH_H + 4 + i * LINE_H, text[i]);
+
+        SDL_SetRenderDrawColor(ren, r, g, b, a);
+    }
+}
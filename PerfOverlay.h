@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "SDL3/SDL.h"
+#include "box2d/box2d.h"
+
+namespace mario {
+
+    /// @brief In-window overlay with a rolling frame-time graph and the cost of each system.
+    ///
+    /// The simulation side times systems with measure() and publishes each frame with
+    /// endSim(); the side that presents reports its own time with endRender() and calls
+    /// draw() before SDL_RenderPresent. Both sides may run on different threads.
+    /// F3 toggles the overlay.
+    class PerfOverlay
+    {
+    public:
+        static constexpr int HISTORY = 120; // Frames shown in the graph
+        static constexpr int MAX_SYSTEMS = 16;
+        static constexpr SDL_Scancode TOGGLE_KEY = SDL_SCANCODE_F3;
+
+        PerfOverlay();
+        ~PerfOverlay();
+
+        PerfOverlay(const PerfOverlay&) = delete;
+        PerfOverlay& operator=(const PerfOverlay&) = delete;
+
+        bool visible() const { return _visible.load(std::memory_order_relaxed); }
+
+        /// @brief Simulation side: runs f and charges its time to the system called name.
+        /// name must outlive the overlay, e.g. a string literal.
+        template <class F>
+        void measure(const char* name, F&& f) {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            const std::chrono::duration<float, std::milli> ms = std::chrono::steady_clock::now() - start;
+            charge(name, ms.count());
+        }
+
+        /// @brief Simulation side: publishes the frame's simulation time and system costs.
+        void endSim(float simMs);
+        /// @brief Like endSim(float), also recording the Box2D step time of world.
+        void endSim(float simMs, b2WorldId world);
+
+        /// @brief Render side: records the time spent drawing and presenting the last frame.
+        void endRender(float renderMs);
+
+        /// @brief Draws the overlay if it is visible.
+        void draw(SDL_Renderer* ren);
+
+    private:
+        struct System {
+            const char* name;
+            float ms;
+        };
+
+        void charge(const char* name, float ms);
+        void publish(float simMs, float physicsMs);
+        static bool watch(void* userdata, SDL_Event* event);
+
+        std::atomic<bool> _visible{false};
+
+        // Written only by the simulation side
+        System _pending[MAX_SYSTEMS] = {};
+        int _pendingCount = 0;
+
+        // Shared, guarded by _mutex
+        std::mutex _mutex;
+        float _sim[HISTORY] = {};
+        float _render[HISTORY] = {};
+        int _frame = 0; // Next slot of the history
+        System _systems[MAX_SYSTEMS] = {};
+        int _systemCount = 0;
+        float _physicsMs = 0;
+        int _entities = 0;
+    };
+}
@@ -1,8 +1,13 @@
 #include "Pong.h"
 #include <iostream>
 #include <SDL3/SDL.h>
-#include <SDL3_image/SDL_image.h>
 #include <box2d/box2d.h>
+#include <chrono>
+#include <thread>
+#include "InputQueue.h"
+#include "Mario.h"
+#include "RenderQueue.h"
+#include "TextureCache.h"
 using namespace std;
 
 Pong::Pong()
@@ -17,18 +22,11 @@ Pong::Pong()
 		cout << SDL_GetError() << endl;
 		return;
 		}
-	SDL_Surface *surf = IMG_Load("res/pong.png");
-	if (surf == nullptr) {
-		cout << SDL_GetError() << endl;
-		return;
-	}
-
-	tex = SDL_CreateTextureFromSurface(ren, surf);
+	tex = mario::TextureCache().load(ren, "res/pong.png");
 	if (tex == nullptr) {
 		cout << SDL_GetError() << endl;
 		return;
 	}
-	SDL_DestroySurface(surf);
 
 	b2WorldDef worldDef = b2DefaultWorldDef();
 	worldDef.gravity = {0,0};
@@ -72,29 +70,44 @@ Pong::~Pong()
 void Pong::run()
 {
 	SDL_SetRenderDrawColor(ren, 0,0,0,255);
-	SDL_FRect r{0,0,
-		BALL_TEX.w*TEX_SCALE,
-		BALL_TEX.h*TEX_SCALE};
-
-	constexpr float STEP = 1.f/FPS;
-	constexpr float RAD_TO_DEG = 57.2958f;
 
-	for (int i = 0; i < 1000; ++i) {
-		b2World_Step(world, STEP, 4);
-
-		b2Vec2 p = b2Body_GetPosition(ballBody);
-		r.x = p.x*BOX_SCALE;
-		r.y = p.y*BOX_SCALE;
-
-		b2Rot rot = b2Body_GetRotation(ballBody);
-		float a = RAD_TO_DEG * b2Rot_GetAngle(rot);
-
-		SDL_RenderClear(ren);
-		SDL_RenderTextureRotated(
-			ren, tex, &BALL_TEX, &r, a,
-			nullptr, SDL_FLIP_NONE);
-		SDL_RenderPresent(ren);
+	// The simulation runs on its own thread and hands each frame to the main thread,
+	// which presents frame N while frame N+1 is simulated
+	mario::InputQueue::start();
+	mario::RenderQueue frames;
+	mario::PerfOverlay perf;
+	thread sim([this, &frames, &perf] {
+		SDL_FRect r{0,0,
+			BALL_TEX.w*TEX_SCALE,
+			BALL_TEX.h*TEX_SCALE};
+
+		constexpr float STEP = 1.f/FPS;
+		constexpr float RAD_TO_DEG = 57.2958f;
+
+		for (int i = 0; i < 1000 && !mario::InputQueue::quitRequested(); ++i) {
+			const auto start = chrono::steady_clock::now();
+			mario::InputSystem::run();
+			perf.measure("b2World_Step", [this] { b2World_Step(world, STEP, 4); });
+
+			b2Vec2 p = b2Body_GetPosition(ballBody);
+			r.x = p.x*BOX_SCALE;
+			r.y = p.y*BOX_SCALE;
+
+			b2Rot rot = b2Body_GetRotation(ballBody);
+			float a = RAD_TO_DEG * b2Rot_GetAngle(rot);
+
+			frames.begin().push_back({tex, BALL_TEX, r, a, SDL_FLIP_NONE});
+			const chrono::duration<float, milli> ms = chrono::steady_clock::now() - start;
+			perf.endSim(ms.count(), world);
+			frames.submit();
+
+			SDL_Delay(5);
+		}
+		frames.close();
+	});
 
-		SDL_Delay(5);
-	}
+	while (frames.present(ren, &perf))
+		SDL_PumpEvents();
+	sim.join();
+	mario::InputQueue::stop();
 }
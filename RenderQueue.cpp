@@ -0,0 +1,62 @@
+#include "RenderQueue.h"
+#include <chrono>
+
+namespace mario
+{
+    std::vector<RenderCommand>& RenderQueue::begin()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        // The renderer may still be drawing from this list
+        _cv.wait(lock, [this] { return _drawing != _back; });
+        _lists[_back].clear();
+        return _lists[_back];
+    }
+
+    void RenderQueue::submit()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this] { return _ready == -1; });
+        _ready = _back;
+        _back ^= 1;
+        _cv.notify_all();
+    }
+
+    void RenderQueue::close()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+        _cv.notify_all();
+    }
+
+    bool RenderQueue::present(SDL_Renderer* ren, PerfOverlay* overlay, Uint32 waitMs)
+    {
+        int list;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait_for(lock, std::chrono::milliseconds(waitMs),
+                         [this] { return _ready != -1 || _closed; });
+            if (_ready == -1)
+                return !_closed;
+            list = _drawing = _ready;
+            _ready = -1;
+            _cv.notify_all();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        SDL_RenderClear(ren);
+        for (const RenderCommand& cmd : _lists[list])
+            SDL_RenderTextureRotated(ren, cmd.texture, &cmd.src, &cmd.dst, cmd.angle, nullptr, cmd.flip);
+        if (overlay != nullptr)
+            overlay->draw(ren);
+        SDL_RenderPresent(ren);
+        if (overlay != nullptr) {
+            const std::chrono::duration<float, std::milli> ms = std::chrono::steady_clock::now() - start;
+            overlay->endRender(ms.count());
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _drawing = -1;
+        _cv.notify_all();
+        return true;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "SDL3/SDL.h"
+#include "PerfOverlay.h"
+
+namespace mario {
+
+    /// @brief RenderCommand holds one textured quad to draw.
+    struct RenderCommand {
+        SDL_Texture* texture;
+        SDL_FRect src; // Region of the texture
+        SDL_FRect dst; // Region of the screen
+        double angle = 0; // Clockwise rotation around the center of dst, in degrees
+        SDL_FlipMode flip = SDL_FLIP_NONE;
+    };
+
+    /// @brief Two render command lists handed from a simulation thread to the thread that draws.
+    ///
+    /// The simulation fills one list while the renderer presents the other, so simulating
+    /// frame N+1 overlaps presenting frame N. The simulation is never more than one frame
+    /// ahead: submit() waits until the renderer has taken the previous frame. SDL requires
+    /// rendering on the thread that created the window, so the renderer side runs on the
+    /// main thread and the simulation is the one moved to a worker.
+    class RenderQueue
+    {
+    public:
+        /// @brief Simulation side: returns the empty list for the next frame.
+        std::vector<RenderCommand>& begin();
+
+        /// @brief Simulation side: publishes the list returned by begin().
+        void submit();
+
+        /// @brief Simulation side: no more frames will follow.
+        void close();
+
+        /// @brief Render side: draws and presents the newest frame if one arrives within
+        /// waitMs; returns false once the queue is closed and every frame was presented.
+        /// A given overlay is drawn on top and told how long presenting took.
+        bool present(SDL_Renderer* ren, PerfOverlay* overlay = nullptr, Uint32 waitMs = 4);
+
+    private:
+        std::vector<RenderCommand> _lists[2];
+        int _back = 0; // List the simulation writes
+        int _ready = -1; // List waiting to be presented
+        int _drawing = -1; // List being presented
+        bool _closed = false;
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+    };
+}
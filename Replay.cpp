@@ -0,0 +1,283 @@
+#include "Replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include "box2d/box2d.h"
+#include "bagel.h"
+#include "InputQueue.h"
+#include "TextureCache.h"
+#include <SDL3/SDL.h>
+
+namespace mario
+{
+    namespace {
+        constexpr char MAGIC[4] = {'B', 'G', 'L', 'R'};
+        constexpr std::uint32_t VERSION = 2; // 2: the scene has Box2D bodies
+
+        enum InputBit : std::uint8_t {
+            UP = 1 << 0, DOWN = 1 << 1, LEFT = 1 << 2, RIGHT = 1 << 3, JUMP = 1 << 4, SHOOT = 1 << 5
+        };
+
+        constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+        constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+        void hashBytes(std::uint64_t& h, const void* data, std::size_t size) {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < size; ++i)
+                h = (h ^ bytes[i]) * FNV_PRIME;
+        }
+
+        constexpr float GROUND_Y = 416; // Top of the floor the scene stands on
+        constexpr float SCENE_WIDTH = 3100;
+        constexpr float BOX_SCALE = Mario::BOX_SCALE;
+        constexpr float HALF_TILE = LEVEL_TILE_SIZE / 2.f;
+
+        // World y grows downward, as in the game
+        b2WorldId createWorld() {
+            b2WorldDef worldDef = b2DefaultWorldDef();
+            worldDef.gravity = {0, 10};
+            return b2CreateWorld(&worldDef);
+        }
+
+        BodyBox tileBody(bagel::ent_type e) {
+            const Position& pos = bagel::World::getComponent<Position>(e);
+            return {pos.x + HALF_TILE, pos.y + HALF_TILE, HALF_TILE, HALF_TILE};
+        }
+    }
+
+    InputRecorder::InputRecorder(const char* path, std::uint64_t seed, std::uint32_t fps)
+        : _file(std::fopen(path, "wb"))
+    {
+        if (_file == nullptr)
+            return;
+        std::fwrite(MAGIC, 1, sizeof(MAGIC), _file);
+        std::fwrite(&VERSION, sizeof(VERSION), 1, _file);
+        std::fwrite(&fps, sizeof(fps), 1, _file);
+        std::fwrite(&seed, sizeof(seed), 1, _file);
+    }
+
+    InputRecorder::~InputRecorder()
+    {
+        if (_file != nullptr)
+            std::fclose(_file);
+    }
+
+    void InputRecorder::record(const Input& input)
+    {
+        if (_file == nullptr)
+            return;
+        const std::uint8_t bits =
+            (input.up ? UP : 0) | (input.down ? DOWN : 0) | (input.left ? LEFT : 0) |
+            (input.right ? RIGHT : 0) | (input.jump ? JUMP : 0) | (input.shoot ? SHOOT : 0);
+        std::fputc(bits, _file);
+    }
+
+    InputReplay::InputReplay(const char* path)
+    {
+        std::FILE* file = std::fopen(path, "rb");
+        if (file == nullptr)
+            return;
+
+        char magic[4];
+        std::uint32_t version = 0;
+        if (std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+            std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+            std::fread(&version, sizeof(version), 1, file) == 1 && version == VERSION &&
+            std::fread(&_fps, sizeof(_fps), 1, file) == 1 &&
+            std::fread(&_seed, sizeof(_seed), 1, file) == 1) {
+            for (int c = std::fgetc(file); c != EOF; c = std::fgetc(file))
+                _ticks.push_back(static_cast<std::uint8_t>(c));
+            _open = true;
+        }
+        std::fclose(file);
+    }
+
+    Input InputReplay::input(std::size_t tick) const
+    {
+        const std::uint8_t bits = _ticks[tick];
+        Input input;
+        input.up = bits & UP;
+        input.down = bits & DOWN;
+        input.left = bits & LEFT;
+        input.right = bits & RIGHT;
+        input.jump = bits & JUMP;
+        input.shoot = bits & SHOOT;
+        return input;
+    }
+
+    bool ReplayProfile::writeCsv(const char* path) const
+    {
+        std::FILE* file = std::fopen(path, "w");
+        if (file == nullptr)
+            return false;
+        std::fprintf(file, "tick,ms\n");
+        for (std::size_t i = 0; i < tickMs.size(); ++i)
+            std::fprintf(file, "%zu,%.6f\n", i, tickMs[i]);
+        std::fclose(file);
+        return true;
+    }
+
+    ReplayProfile ReplayRunner::run(const InputReplay& replay)
+    {
+        using clock = std::chrono::steady_clock;
+
+        ReplayProfile profile;
+        b2WorldId world = createWorld();
+        buildScene(replay.seed(), world);
+        const float step = 1.f / static_cast<float>(replay.fps());
+
+        profile.tickMs.reserve(replay.ticks());
+        for (std::size_t i = 0; i < replay.ticks(); ++i) {
+            const clock::time_point start = clock::now();
+
+            InputSystem::inject(replay.input(i));
+            tick(step, world);
+
+            const std::chrono::duration<double, std::milli> ms = clock::now() - start;
+            profile.tickMs.push_back(ms.count());
+            profile.totalMs += ms.count();
+        }
+
+        b2DestroyWorld(world);
+        profile.stateHash = hashState();
+        return profile;
+    }
+
+    bool ReplayRunner::record(const char* path, std::uint64_t seed, SDL_Renderer* renderer, std::uint32_t fps)
+    {
+        using clock = std::chrono::steady_clock;
+
+        InputRecorder recorder(path, seed, fps);
+        if (!recorder.isOpen())
+            return false;
+
+        b2WorldId world = createWorld();
+        buildScene(seed, world);
+        const TextureCache textures;
+        SDL_Texture* players = textures.load(renderer, "res/Mario & Luigi.png");
+        SDL_Texture* enemies = textures.load(renderer, "res/Enemies & Bosses.png");
+        dress(players, enemies);
+
+        bagel::ent_type player{}, camera{};
+        bagel::World::forEach<Input>([&](bagel::ent_type e) { player = e; });
+        bagel::World::forEach<Camera>([&](bagel::ent_type e) { camera = e; });
+
+        const float step = 1.f / static_cast<float>(fps);
+        const Uint32 frameMs = 1000 / fps;
+        PerfOverlay perf;
+        SDL_SetRenderDrawColor(renderer, 92, 148, 252, 255);
+
+        InputQueue::start();
+        while (!InputQueue::quitRequested()) {
+            const clock::time_point simStart = clock::now();
+            InputSystem::run();
+            recorder.record(InputSystem::state());
+            tick(step, world, &perf);
+            const std::chrono::duration<float, std::milli> simMs = clock::now() - simStart;
+            perf.endSim(simMs.count(), world);
+
+            // Keep the player a third of the way into the view
+            const Camera& c = bagel::World::getComponent<Camera>(camera);
+            bagel::World::getComponent<Position>(camera).x =
+                std::max(0.f, bagel::World::getComponent<Position>(player).x - c.width / 3.f);
+
+            const clock::time_point renderStart = clock::now();
+            SDL_RenderClear(renderer);
+            RenderSystem::run(renderer);
+            perf.draw(renderer);
+            SDL_RenderPresent(renderer);
+            const std::chrono::duration<float, std::milli> renderMs = clock::now() - renderStart;
+            perf.endRender(renderMs.count());
+
+            InputQueue::waitFor(frameMs);
+        }
+        InputQueue::stop();
+
+        if (players != nullptr)
+            SDL_DestroyTexture(players);
+        if (enemies != nullptr)
+            SDL_DestroyTexture(enemies);
+        b2DestroyWorld(world);
+        return true;
+    }
+
+    std::uint64_t ReplayRunner::hashState()
+    {
+        std::uint64_t h = FNV_OFFSET;
+        bagel::World::forEach<Position>([&](bagel::ent_type e) {
+            bagel::Entity entity{e};
+            hashBytes(h, &e.id, sizeof(e.id));
+            hashBytes(h, &entity.get<Position>(), sizeof(Position));
+            if (entity.has<Movement>())
+                hashBytes(h, &entity.get<Movement>(), sizeof(Movement));
+            if (entity.has<State>()) {
+                const State& state = entity.get<State>();
+                const bool flags[] = {state.isWalking, state.isOnGround, state.isAlive, state.isVisible};
+                hashBytes(h, flags, sizeof(flags));
+            }
+        });
+        return h;
+    }
+
+    void ReplayRunner::buildScene(std::uint64_t seed, b2WorldId world)
+    {
+        bagel::World::reset();
+        ScoreSystem::reset();
+        LifetimeSystem::reset();
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<float> x(0.f, 3000.f);
+
+        const bagel::Entity player{createMario(40, GROUND_Y - LEVEL_TILE_SIZE, nullptr)};
+        createBody(world, BOX_SCALE, player, tileBody(player.entity()));
+        createCamera(0, 0);
+        for (int i = 0; i < 32; ++i) {
+            bagel::ent_type wave[4];
+            createEnemies(wave, 4, x(rng), GROUND_Y - LEVEL_TILE_SIZE, 24, EnemyType::Goomba, 100);
+            for (const bagel::ent_type e : wave)
+                createBody(world, BOX_SCALE, bagel::Entity{e}, tileBody(e));
+        }
+
+        // The floor belongs to no entity, so touching it produces no collision pairs
+        b2BodyDef groundDef = b2DefaultBodyDef();
+        groundDef.position = {SCENE_WIDTH / 2.f / BOX_SCALE, (GROUND_Y + HALF_TILE) / BOX_SCALE};
+        const b2BodyId ground = b2CreateBody(world, &groundDef);
+        const b2ShapeDef groundShape = b2DefaultShapeDef();
+        const b2Polygon groundBox = b2MakeBox(SCENE_WIDTH / 2.f / BOX_SCALE, HALF_TILE / BOX_SCALE);
+        b2CreatePolygonShape(ground, &groundShape, &groundBox);
+    }
+
+    void ReplayRunner::dress(SDL_Texture* players, SDL_Texture* enemies)
+    {
+        bagel::World::forEach<Input, Texture>([&](bagel::ent_type e) {
+            bagel::World::getComponent<Texture>(e) = {players, {0, 8, 16, 16}, {0, 0, 0, 0}};
+        });
+        bagel::World::forEach<Enemy, Texture>([&](bagel::ent_type e) {
+            bagel::World::getComponent<Texture>(e) = {enemies, {0, 16, 16, 16}, {0, 0, 0, 0}};
+        });
+    }
+
+    void ReplayRunner::tick(float dt, b2WorldId world, PerfOverlay* perf)
+    {
+        const auto step = [perf](const char* name, auto&& system) {
+            if (perf != nullptr)
+                perf->measure(name, system);
+            else
+                system();
+        };
+
+        // Player control and movement share Movement, so they run as one pass
+        step("Movement", [] { bagel::Pipeline<PlayerControlSystem, MovemntSystem>::run(); });
+        step("Hierarchy", [] { HierarchySystem::run(); });
+        step("b2World_Step", [&] { b2World_Step(world, dt, 4); });
+        step("Collision", [&] { CollisionSystem::run(world); });
+        step("PowerUps", [] { PowerUpsSystem::run(); });
+        step("Death", [] { DeathSystem::run(); });
+        step("Score", [] { ScoreSystem::run(); });
+        step("Death sweep", [] { DeathSystem::sweep(); });
+        step("Animation", [&] { AnimationSystem::run(dt); });
+        step("Camera", [] { CameraSystem::run(); });
+        step("Lifetime", [&] { LifetimeSystem::run(dt); });
+        step("Culling", [] { CullingSystem::run(); });
+    }
+}
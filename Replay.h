@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Mario.h"
+#include "PerfOverlay.h"
+
+namespace mario {
+
+    /// @brief Writes the input of every tick and the session seed to a compact binary file.
+    ///
+    /// File layout: magic "BGLR", format version, ticks per second and seed,
+    /// followed by one byte of Input flags per tick.
+    class InputRecorder
+    {
+    public:
+        InputRecorder(const char* path, std::uint64_t seed, std::uint32_t fps);
+        ~InputRecorder();
+
+        InputRecorder(const InputRecorder&) = delete;
+        InputRecorder& operator=(const InputRecorder&) = delete;
+
+        bool isOpen() const { return _file != nullptr; }
+        void record(const Input& input);
+
+    private:
+        std::FILE* _file;
+    };
+
+    /// @brief A recorded session loaded from an InputRecorder file.
+    class InputReplay
+    {
+    public:
+        explicit InputReplay(const char* path);
+
+        bool isOpen() const { return _open; }
+        std::uint64_t seed() const { return _seed; }
+        std::uint32_t fps() const { return _fps; }
+        std::size_t ticks() const { return _ticks.size(); }
+        Input input(std::size_t tick) const;
+
+    private:
+        bool _open = false;
+        std::uint64_t _seed = 0;
+        std::uint32_t _fps = 60;
+        std::vector<std::uint8_t> _ticks;
+    };
+
+    /// @brief ReplayProfile holds the cost of every replayed tick and the state it ended in.
+    struct ReplayProfile {
+        std::vector<double> tickMs; // Simulation time of each tick in milliseconds
+        double totalMs = 0; // Sum of tickMs
+        std::uint64_t stateHash = 0; // Hash of the final world state
+
+        /// @brief Writes one "tick,ms" line per tick.
+        bool writeCsv(const char* path) const;
+    };
+
+    /// @brief Replays a recorded session headless, at a fixed step and without delays.
+    class ReplayRunner final: bagel::NoInstance
+    {
+    public:
+        /// @brief Builds the scene from the recorded seed, feeds each tick's input to the
+        /// systems and returns the per-tick timings and final state hash.
+        static ReplayProfile run(const InputReplay& replay);
+
+        /// @brief Records a live session: samples input each tick, writes it to path and
+        /// steps and draws with renderer the same scene the replay will rebuild. Runs until
+        /// the window is closed.
+        static bool record(const char* path, std::uint64_t seed, SDL_Renderer* renderer,
+                           std::uint32_t fps = 60);
+
+        /// @brief Hashes the Position, Movement and State of every entity in id order.
+        static std::uint64_t hashState();
+
+        /// @brief Resets the world and spawns the scene generated from seed, with the
+        /// Box2D bodies of its colliders in world.
+        static void buildScene(std::uint64_t seed, b2WorldId world);
+
+        /// @brief Runs every gameplay system once, in a fixed order, stepping world
+        /// between movement and collision handling. Systems are timed into perf if given.
+        static void tick(float dt, b2WorldId world, PerfOverlay* perf = nullptr);
+
+    private:
+        /// @brief Gives the player and enemies of the scene their sprites from the sheets.
+        static void dress(SDL_Texture* players, SDL_Texture* enemies);
+    };
+}
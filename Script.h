@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/// Stackless scripts: a script's body is a member function bracketed by SCRIPT_BEGIN and
+/// SCRIPT_END that returns true while it has more to do. SCRIPT_YIELD and SCRIPT_WAIT
+/// return from the body and the next call resumes right after them, so scripts read as
+/// plain loops yet suspend without a thread or stack of their own. Locals do not survive
+/// a suspension; keep loop counters and other state in members.
+#define SCRIPT_BEGIN(state) switch ((state).line) { case 0:
+#define SCRIPT_YIELD(state) \
+    do { (state).line = __LINE__; return true; case __LINE__:; } while (0)
+#define SCRIPT_WAIT(state, ticks) \
+    do { (state).wait = (ticks); (state).line = __LINE__; return true; \
+         case __LINE__: if (--(state).wait > 0) return true; } while (0)
+#define SCRIPT_END(state) } (state).line = -1; return false
+
+namespace mario {
+
+    /// @brief ScriptState holds where a stackless script resumes.
+    struct ScriptState {
+        int line = 0; // Source line of the last suspension; 0 before the start, -1 once finished
+        int wait = 0; // Resumes left before SCRIPT_WAIT continues
+    };
+
+    /// @brief Resumes every script once per tick, on the calling thread.
+    ///
+    /// Scripts are stored by value in one array reserved up front, so ticking allocates
+    /// nothing. Script must provide bool resume(Args&...), returning false when finished;
+    /// finished scripts are removed.
+    template <class Script>
+    class ScriptScheduler
+    {
+    public:
+        explicit ScriptScheduler(std::size_t capacity) { _scripts.reserve(capacity); }
+
+        Script& add(const Script& script) {
+            _scripts.push_back(script);
+            return _scripts.back();
+        }
+
+        /// @brief Resumes every script with args; returns the number still running.
+        template <class ...Args>
+        std::size_t tick(Args&... args) {
+            for (std::size_t i = 0; i < _scripts.size();) {
+                if (_scripts[i].resume(args...)) {
+                    ++i;
+                } else {
+                    _scripts[i] = _scripts.back();
+                    _scripts.pop_back();
+                }
+            }
+            return _scripts.size();
+        }
+
+        std::size_t size() const { return _scripts.size(); }
+        bool empty() const { return _scripts.empty(); }
+
+    private:
+        std::vector<Script> _scripts;
+    };
+}
@@ -0,0 +1,156 @@
+#include "Stress.h"
+#include <chrono>
+#include <ostream>
+#include <random>
+#include <vector>
+#include "Replay.h"
+#include "bagel.h"
+
+namespace mario
+{
+    namespace {
+        /// @brief Live entities of one kind; removal swaps with the last element.
+        class Population
+        {
+        public:
+            void add(bagel::ent_type e) { _live.push_back(e); }
+            bool empty() const { return _live.empty(); }
+
+            template <class Rng>
+            bagel::ent_type take(Rng& rng) {
+                std::uniform_int_distribution<std::size_t> pick(0, _live.size()-1);
+                const std::size_t i = pick(rng);
+                const bagel::ent_type e = _live[i];
+                _live[i] = _live.back();
+                _live.pop_back();
+                return e;
+            }
+
+        private:
+            std::vector<bagel::ent_type> _live;
+        };
+
+        /// @brief Turns a fractional per-tick rate into a whole count, carrying the remainder.
+        int due(float rate, float& carry) {
+            carry += rate;
+            const int n = static_cast<int>(carry);
+            carry -= static_cast<float>(n);
+            return n;
+        }
+    }
+
+    StressConfig StressConfig::scaled(int total, int ticks)
+    {
+        StressConfig config;
+        const StressConfig defaults;
+        const int base = defaults.enemies + defaults.blocks + defaults.collectables + defaults.projectiles;
+        const double k = static_cast<double>(total) / base;
+
+        config.enemies = static_cast<int>(defaults.enemies * k);
+        config.blocks = static_cast<int>(defaults.blocks * k);
+        config.collectables = static_cast<int>(defaults.collectables * k);
+        config.projectiles = total - config.enemies - config.blocks - config.collectables;
+        config.spawnRate = static_cast<float>(defaults.spawnRate * k);
+        config.killRate = static_cast<float>(defaults.killRate * k);
+        config.collectRate = static_cast<float>(defaults.collectRate * k);
+        config.powerUpRate = static_cast<float>(defaults.powerUpRate * k);
+        config.worldWidth = static_cast<float>(defaults.worldWidth * k);
+        config.ticks = ticks;
+        return config;
+    }
+
+    StressResult StressScene::run(const StressConfig& config)
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::mt19937_64 rng(config.seed);
+        std::uniform_real_distribution<float> x(0.f, config.worldWidth);
+        std::uniform_real_distribution<float> y(0.f, 480.f);
+        std::uniform_int_distribution<int> enemyType(0, static_cast<int>(EnemyType::Bowser));
+        std::uniform_int_distribution<int> blockType(0, static_cast<int>(BlockType::Solid));
+        std::uniform_int_distribution<int> itemType(0, static_cast<int>(CollectableType::Star));
+
+        Population enemies, collectables;
+        StressResult result;
+
+        bagel::World::reset();
+        LifetimeSystem::reset();
+        createMario(40, 400, nullptr);
+        createCamera(0, 0);
+
+        for (int i = 0; i < config.enemies; ++i)
+            enemies.add(createEnemy(x(rng), y(rng), static_cast<EnemyType>(enemyType(rng)), 100));
+        for (int i = 0; i < config.blocks; ++i) {
+            const auto type = static_cast<BlockType>(blockType(rng));
+            createBlock(x(rng), y(rng), type, type == BlockType::Question, 1, type == BlockType::Brick,
+                        type == BlockType::Question ? CollectableType::Mushroom : CollectableType::None);
+        }
+        for (int i = 0; i < config.collectables; ++i)
+            collectables.add(createCollectable(x(rng), y(rng), static_cast<CollectableType>(itemType(rng)), 200));
+        for (int i = 0; i < config.projectiles; ++i)
+            LifetimeSystem::add(createProjectile(x(rng), y(rng)), 2.f);
+
+        b2WorldDef worldDef = b2DefaultWorldDef();
+        b2WorldId world = b2CreateWorld(&worldDef);
+        float spawnCarry = 0, killCarry = 0, collectCarry = 0, powerUpCarry = 0;
+        const clock::time_point start = clock::now();
+
+        for (int t = 0; t < config.ticks; ++t) {
+            const clock::time_point tickStart = clock::now();
+
+            for (int n = due(config.spawnRate, spawnCarry); n > 0; --n, ++result.spawned) {
+                if (n & 1)
+                    enemies.add(createEnemy(x(rng), y(rng), static_cast<EnemyType>(enemyType(rng)), 100));
+                else
+                    LifetimeSystem::add(createProjectile(x(rng), y(rng)), 2.f);
+            }
+            for (int n = due(config.killRate, killCarry); n > 0 && !enemies.empty(); --n, ++result.killed)
+                bagel::World::destroyEntity(enemies.take(rng));
+            for (int n = due(config.collectRate, collectCarry); n > 0 && !collectables.empty(); --n, ++result.collected)
+                bagel::World::destroyEntity(collectables.take(rng));
+            for (int n = due(config.powerUpRate, powerUpCarry); n > 0 && !collectables.empty(); --n, ++result.poweredUp) {
+                // A released power-up starts moving: it gains Movement and Physics, and is
+                // replaced by a fresh collectable so the population stays level
+                bagel::Entity item{collectables.take(rng)};
+                item.get<Collectable>().type = CollectableType::Mushroom;
+                if (!item.has<Movement>())
+                    item.addAll(Movement{1.f, 0.f}, Physics{});
+                collectables.add(createCollectable(x(rng), y(rng), CollectableType::Coin, 200));
+            }
+
+            ReplayRunner::tick(config.dt, world);
+
+            const std::chrono::duration<double, std::milli> ms = clock::now() - tickStart;
+            if (ms.count() > result.worstTickMs)
+                result.worstTickMs = ms.count();
+            if (bagel::World::entities() > result.peakEntities)
+                result.peakEntities = bagel::World::entities();
+        }
+
+        result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+        b2DestroyWorld(world);
+        result.ticks = config.ticks;
+        result.ticksPerSecond = result.seconds > 0 ? config.ticks / result.seconds : 0;
+        result.report = bagel::World::report();
+        result.reservedBytes = result.report.maskBytes + result.report.columnBytes;
+        for (const bagel::ComponentReport& c : result.report)
+            result.reservedBytes += c.storage.reservedBytes + c.storage.indexBytes;
+        return result;
+    }
+
+    void StressResult::print(std::ostream& os) const
+    {
+        os << ticks << " ticks in " << seconds << " s (" << ticksPerSecond << " ticks/s, worst "
+           << worstTickMs << " ms)\n"
+           << "entities: " << report.entities << " live, " << peakEntities << " peak, "
+           << report.freeIds << " free ids\n"
+           << "churn: " << spawned << " spawned, " << killed << " killed, " << collected
+           << " collected, " << poweredUp << " powered up\n"
+           << "memory: " << reservedBytes / 1024 << " KiB (masks " << report.maskBytes / 1024
+           << ", columns " << report.columnBytes / 1024 << ")\n";
+        for (const bagel::ComponentReport& c : report)
+            os << "  " << c.name << ": " << c.storage.count << " x " << c.componentSize << " B in "
+               << c.storage.storage << ", " << (c.storage.reservedBytes + c.storage.indexBytes) / 1024
+               << " KiB\n";
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+
+#include "Mario.h"
+
+namespace mario {
+
+    /// @brief StressConfig describes the size and churn of a stress scene.
+    /// Entity counts are the initial population; rates are events per tick and may be fractional.
+    struct StressConfig {
+        int enemies = 4000;
+        int blocks = 3000;
+        int collectables = 2000;
+        int projectiles = 1000;
+        int ticks = 600;
+        float dt = 1.f / 60.f; // Fixed simulation step
+
+        float spawnRate = 20; // Enemies and projectiles spawned per tick
+        float killRate = 15; // Enemies destroyed per tick
+        float collectRate = 10; // Collectables picked up (destroyed) per tick
+        float powerUpRate = 2; // Collectables turned into moving power-ups per tick
+        float worldWidth = 20000; // Entities spawn in [0, worldWidth)
+        std::uint64_t seed = 1;
+
+        /// @brief Splits total over the four kinds in the default proportions.
+        static StressConfig scaled(int total, int ticks = 600);
+    };
+
+    /// @brief StressResult holds the throughput and memory footprint of a stress run.
+    struct StressResult {
+        int ticks = 0;
+        double seconds = 0; // Wall time spent in the systems and churn
+        double ticksPerSecond = 0;
+        double worstTickMs = 0;
+        bagel::size_type peakEntities = 0;
+        std::size_t spawned = 0, killed = 0, collected = 0, poweredUp = 0;
+        bagel::WorldReport report{}; // World state after the last tick
+        std::size_t reservedBytes = 0; // Masks, columns and component storages after the last tick
+
+        void print(std::ostream& os) const;
+    };
+
+    /// @brief Builds a large scene with the Mario entity factories and runs every system
+    /// over it for a number of ticks while spawning and destroying entities.
+    class StressScene final: bagel::NoInstance
+    {
+    public:
+        static StressResult run(const StressConfig& config);
+    };
+}
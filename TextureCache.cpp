@@ -0,0 +1,119 @@
+#include "TextureCache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <SDL3_image/SDL_image.h>
+#include "MappedFile.h"
+
+namespace mario
+{
+    namespace {
+        constexpr char MAGIC[4] = {'B', 'G', 'L', 'T'};
+        constexpr std::uint32_t VERSION = 1;
+
+        constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+        constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+        struct Header {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t width, height;
+            std::uint32_t pitch; // Bytes per pixel row
+            std::uint32_t reserved;
+            std::uint64_t sourceHash;
+        };
+    }
+
+    TextureCache::TextureCache(std::string dir) : _dir(std::move(dir))
+    {
+    }
+
+    SDL_Texture* TextureCache::load(SDL_Renderer* renderer, const char* path) const
+    {
+        const std::uint64_t hash = hashFile(path);
+        if (hash == 0)
+            return decode(renderer, path, {}, 0);
+
+        const std::string cache = cachePath(path);
+        if (SDL_Texture* texture = loadCached(renderer, cache, hash))
+            return texture;
+        return decode(renderer, path, cache, hash);
+    }
+
+    std::uint64_t TextureCache::hashFile(const char* path)
+    {
+        const MappedFile file(path);
+        if (!file.isOpen())
+            return 0;
+        std::uint64_t h = FNV_OFFSET;
+        const auto* bytes = static_cast<const unsigned char*>(file.data());
+        for (std::size_t i = 0; i < file.size(); ++i)
+            h = (h ^ bytes[i]) * FNV_PRIME;
+        return h;
+    }
+
+    std::string TextureCache::cachePath(const char* path) const
+    {
+        return _dir + "/" + std::filesystem::path(path).filename().string() + ".rgba";
+    }
+
+    SDL_Texture* TextureCache::loadCached(SDL_Renderer* renderer, const std::string& cache, std::uint64_t hash) const
+    {
+        const MappedFile file(cache.c_str());
+        if (file.size() < sizeof(Header))
+            return nullptr;
+
+        Header header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            header.sourceHash != hash || header.pitch < header.width * 4 ||
+            sizeof(Header) + static_cast<std::size_t>(header.pitch) * header.height > file.size())
+            return nullptr;
+
+        // The surface borrows the mapped pixels; the texture copies them to the GPU
+        void* pixels = const_cast<char*>(static_cast<const char*>(file.data()) + sizeof(Header));
+        SDL_Surface* surf = SDL_CreateSurfaceFrom(header.width, header.height, SDL_PIXELFORMAT_RGBA32,
+                                                  pixels, header.pitch);
+        if (surf == nullptr)
+            return nullptr;
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surf);
+        SDL_DestroySurface(surf);
+        return texture;
+    }
+
+    SDL_Texture* TextureCache::decode(SDL_Renderer* renderer, const char* path, const std::string& cache,
+                                      std::uint64_t hash) const
+    {
+        SDL_Surface* loaded = IMG_Load(path);
+        if (loaded == nullptr)
+            return nullptr;
+        SDL_Surface* surf = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+        SDL_DestroySurface(loaded);
+        if (surf == nullptr)
+            return nullptr;
+
+        if (!cache.empty()) {
+            std::error_code ec;
+            std::filesystem::create_directories(_dir, ec);
+            if (std::FILE* file = std::fopen(cache.c_str(), "wb")) {
+                Header header = {};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.version = VERSION;
+                header.width = surf->w;
+                header.height = surf->h;
+                header.pitch = surf->w * 4;
+                header.sourceHash = hash;
+                std::fwrite(&header, sizeof(header), 1, file);
+                for (int row = 0; row < surf->h; ++row)
+                    std::fwrite(static_cast<const char*>(surf->pixels) + row * surf->pitch, 1, header.pitch, file);
+                const bool failed = std::ferror(file) != 0;
+                if (std::fclose(file) != 0 || failed)
+                    std::remove(cache.c_str());
+            }
+        }
+
+        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surf);
+        SDL_DestroySurface(surf);
+        return texture;
+    }
+}
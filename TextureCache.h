@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "SDL3/SDL.h"
+
+namespace mario {
+
+    /// @brief Creates textures from images through a cache of their decoded pixels.
+    ///
+    /// The first load of an image decodes it and writes its RGBA32 pixels to
+    /// `<dir>/<image file name>.rgba`: a header holding the size, pitch and a hash of the
+    /// source file, followed by the pixel rows. Later loads hash the source, map the cache
+    /// file and upload its pixels directly, skipping the PNG decode. A cache file whose
+    /// hash no longer matches the source is decoded and written again.
+    class TextureCache
+    {
+    public:
+        explicit TextureCache(std::string dir = "cache");
+
+        /// @brief Returns a texture holding the image at path, or nullptr with the SDL
+        /// error set if it cannot be read.
+        SDL_Texture* load(SDL_Renderer* renderer, const char* path) const;
+
+        /// @brief 64-bit FNV-1a hash of a file's contents; 0 if it cannot be read.
+        static std::uint64_t hashFile(const char* path);
+
+    private:
+        std::string cachePath(const char* path) const;
+        SDL_Texture* loadCached(SDL_Renderer* renderer, const std::string& cache, std::uint64_t hash) const;
+        SDL_Texture* decode(SDL_Renderer* renderer, const char* path, const std::string& cache, std::uint64_t hash) const;
+
+        std::string _dir;
+    };
+}
@@ -0,0 +1,234 @@
+#include "Tilemap.h"
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include "SDL3/SDL.h"
+#include "box2d/box2d.h"
+#include "LevelFile.h"
+
+namespace mario
+{
+    Tilemap::Tilemap(int columns, int rows, SDL_Texture* sheet)
+        : _columns(columns), _rows(rows),
+          _chunkColumns((columns + CHUNK_TILES - 1) / CHUNK_TILES),
+          _chunkRows((rows + CHUNK_TILES - 1) / CHUNK_TILES),
+          _sheet(sheet),
+          _tiles(static_cast<std::size_t>(columns) * rows, EMPTY),
+          _chunks(static_cast<std::size_t>(_chunkColumns) * _chunkRows)
+    {
+    }
+
+    Tilemap::~Tilemap()
+    {
+        for (Chunk& chunk : _chunks)
+            if (chunk.texture != nullptr)
+                SDL_DestroyTexture(chunk.texture);
+    }
+
+    void Tilemap::defineTile(char symbol, int srcX, int srcY, bool solid)
+    {
+        TileInfo& info = _info[static_cast<std::uint8_t>(symbol)];
+        info.defined = true;
+        info.solid = solid;
+        info.dynamic = false;
+        info.src = {static_cast<float>(srcX), static_cast<float>(srcY), TILE_SIZE, TILE_SIZE};
+    }
+
+    void Tilemap::defineBlock(char symbol, BlockType type, CollectableType collectable)
+    {
+        TileInfo& info = _info[static_cast<std::uint8_t>(symbol)];
+        info.defined = true;
+        info.solid = true;
+        info.dynamic = true;
+        info.block = type;
+        info.collectable = collectable;
+    }
+
+    void Tilemap::load(const char* const* rows, int count)
+    {
+        for (int row = 0; row < count && row < _rows; ++row) {
+            const int length = static_cast<int>(std::strlen(rows[row]));
+            for (int column = 0; column < length && column < _columns; ++column) {
+                const auto symbol = static_cast<std::uint8_t>(rows[row][column]);
+                const TileInfo& info = _info[symbol];
+                if (!info.defined)
+                    continue;
+
+                if (info.dynamic) {
+                    const bool holds = info.collectable != CollectableType::None;
+                    createBlock(static_cast<float>(column * TILE_SIZE), static_cast<float>(row * TILE_SIZE),
+                                info.block, holds, 1, info.block == BlockType::Brick, info.collectable);
+                } else {
+                    set(column, row, symbol);
+                }
+            }
+        }
+    }
+
+    void Tilemap::load(const LevelFile& level)
+    {
+        for (int i = 0; i < level.tileDefCount(); ++i) {
+            const TileDef& def = level.tileDefs()[i];
+            defineTile(static_cast<char>(def.symbol), def.srcX, def.srcY, def.solid);
+        }
+
+        const std::uint8_t* tiles = level.tiles();
+        for (int row = 0; row < level.rows() && row < _rows; ++row)
+            for (int column = 0; column < level.columns() && column < _columns; ++column)
+                set(column, row, tiles[static_cast<std::size_t>(row) * level.columns() + column]);
+    }
+
+    void Tilemap::set(int column, int row, std::uint8_t tile)
+    {
+        if (!contains(column, row))
+            return;
+
+        std::uint8_t& cell = _tiles[static_cast<std::size_t>(row) * _columns + column];
+        if (cell == tile)
+            return;
+
+        Chunk& chunk = chunkAt(column, row);
+        chunk.tileCount += (tile != EMPTY) - (cell != EMPTY);
+        chunk.dirty = true;
+        cell = tile;
+    }
+
+    void Tilemap::bake(SDL_Renderer* renderer)
+    {
+        // Baking switches the target and draw color; the caller's are restored at the end
+        SDL_Texture* target = SDL_GetRenderTarget(renderer);
+        Uint8 r, g, b, a;
+        SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+
+        for (int cy = 0; cy < _chunkRows; ++cy) {
+            for (int cx = 0; cx < _chunkColumns; ++cx) {
+                Chunk& chunk = _chunks[static_cast<std::size_t>(cy) * _chunkColumns + cx];
+                if (!chunk.dirty)
+                    continue;
+                chunk.dirty = false;
+
+                if (chunk.tileCount == 0) {
+                    if (chunk.texture != nullptr) {
+                        SDL_DestroyTexture(chunk.texture);
+                        chunk.texture = nullptr;
+                    }
+                    continue;
+                }
+
+                if (chunk.texture == nullptr) {
+                    chunk.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
+                                                      SDL_TEXTUREACCESS_TARGET, CHUNK_SIZE, CHUNK_SIZE);
+                    if (chunk.texture == nullptr) {
+                        std::cout << SDL_GetError() << std::endl;
+                        continue;
+                    }
+                    SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_BLEND);
+                }
+
+                SDL_SetRenderTarget(renderer, chunk.texture);
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+                SDL_RenderClear(renderer);
+
+                const int lastRow = std::min(_rows, (cy + 1) * CHUNK_TILES);
+                const int lastColumn = std::min(_columns, (cx + 1) * CHUNK_TILES);
+                for (int row = cy * CHUNK_TILES; row < lastRow; ++row) {
+                    for (int column = cx * CHUNK_TILES; column < lastColumn; ++column) {
+                        const std::uint8_t tile = get(column, row);
+                        if (tile == EMPTY)
+                            continue;
+
+                        const SDL_FRect dst = {
+                            static_cast<float>((column - cx * CHUNK_TILES) * TILE_SIZE),
+                            static_cast<float>((row - cy * CHUNK_TILES) * TILE_SIZE),
+                            TILE_SIZE, TILE_SIZE
+                        };
+                        SDL_RenderTexture(renderer, _sheet, &_info[tile].src, &dst);
+                    }
+                }
+            }
+        }
+        SDL_SetRenderTarget(renderer, target);
+        SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    }
+
+    void Tilemap::invalidate()
+    {
+        for (Chunk& chunk : _chunks)
+            chunk.dirty = true;
+    }
+
+    b2BodyId Tilemap::buildColliders(b2WorldId world, float boxScale) const
+    {
+        b2BodyDef bodyDef = b2DefaultBodyDef();
+        bodyDef.type = b2_staticBody;
+        bodyDef.position = {0, 0};
+        b2BodyId body = b2CreateBody(world, &bodyDef);
+
+        b2ShapeDef shapeDef = b2DefaultShapeDef();
+        const float half = TILE_SIZE / 2.f / boxScale;
+
+        for (int row = 0; row < _rows; ++row) {
+            int column = 0;
+            while (column < _columns) {
+                if (!_info[get(column, row)].solid) {
+                    ++column;
+                    continue;
+                }
+
+                const int start = column;
+                while (column < _columns && _info[get(column, row)].solid)
+                    ++column;
+
+                const float halfWidth = (column - start) * half;
+                b2Polygon box = b2MakeOffsetBox(halfWidth, half,
+                    {start * TILE_SIZE / boxScale + halfWidth, row * TILE_SIZE / boxScale + half},
+                    b2Rot_identity);
+                b2CreatePolygonShape(body, &shapeDef, &box);
+            }
+        }
+        return body;
+    }
+
+    b2BodyId Tilemap::buildColliders(b2WorldId world, float boxScale, const LevelFile& level)
+    {
+        b2BodyDef bodyDef = b2DefaultBodyDef();
+        bodyDef.type = b2_staticBody;
+        bodyDef.position = {0, 0};
+        b2BodyId body = b2CreateBody(world, &bodyDef);
+
+        b2ShapeDef shapeDef = b2DefaultShapeDef();
+        for (int i = 0; i < level.solidCount(); ++i) {
+            const BodyBox& solid = level.solids()[i];
+            b2Polygon box = b2MakeOffsetBox(solid.halfWidth / boxScale, solid.halfHeight / boxScale,
+                                            {solid.x / boxScale, solid.y / boxScale}, b2Rot_identity);
+            b2CreatePolygonShape(body, &shapeDef, &box);
+        }
+        return body;
+    }
+
+    void Tilemap::render(SDL_Renderer* renderer, const Position& cam, const Camera& camera) const
+    {
+        const float sx = camera.viewport.w / camera.width;
+        const float sy = camera.viewport.h / camera.height;
+
+        const int firstX = std::max(0, static_cast<int>(cam.x) / CHUNK_SIZE);
+        const int firstY = std::max(0, static_cast<int>(cam.y) / CHUNK_SIZE);
+        const int lastX = std::min(_chunkColumns - 1, static_cast<int>(cam.x + camera.width) / CHUNK_SIZE);
+        const int lastY = std::min(_chunkRows - 1, static_cast<int>(cam.y + camera.height) / CHUNK_SIZE);
+
+        for (int cy = firstY; cy <= lastY; ++cy) {
+            for (int cx = firstX; cx <= lastX; ++cx) {
+                const Chunk& chunk = _chunks[static_cast<std::size_t>(cy) * _chunkColumns + cx];
+                if (chunk.texture == nullptr)
+                    continue;
+
+                const SDL_FRect dst = {
+                    camera.viewport.x + (cx * CHUNK_SIZE - cam.x) * sx,
+                    camera.viewport.y + (cy * CHUNK_SIZE - cam.y) * sy,
+                    CHUNK_SIZE * sx, CHUNK_SIZE * sy
+                };
+                SDL_RenderTexture(renderer, chunk.texture, nullptr, &dst);
+            }
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "SDL3/SDL.h"
+#include "box2d/box2d.h"
+#include "Mario.h"
+#include "LevelTypes.h"
+
+namespace mario {
+
+    class LevelFile;
+
+    /// @brief Stores the static tiles of a level in a compact grid and draws them as pre-baked chunks.
+    ///
+    /// Every static tile is one byte in the grid. The grid is split into square chunks that are
+    /// baked once into render-target textures, so drawing an on-screen chunk is a single draw call.
+    /// Dynamic tiles (question blocks, breakable bricks) are not stored in the grid; they are
+    /// spawned as regular entities through `createBlock`.
+    class Tilemap
+    {
+    public:
+        static constexpr int TILE_SIZE = LEVEL_TILE_SIZE; // Size of a tile in pixels, both in the sheet and in the world
+        static constexpr int CHUNK_TILES = 16; // Width and height of a chunk in tiles
+        static constexpr int CHUNK_SIZE = TILE_SIZE * CHUNK_TILES; // Width and height of a chunk in pixels
+        static constexpr std::uint8_t EMPTY = EMPTY_TILE; // Tile id of an empty cell
+
+        /// @param columns,rows Size of the level in tiles.
+        /// @param sheet Texture holding the tile graphics (e.g. "res/World 1-1.png").
+        Tilemap(int columns, int rows, SDL_Texture* sheet);
+        ~Tilemap();
+
+        Tilemap(const Tilemap&) = delete;
+        Tilemap& operator=(const Tilemap&) = delete;
+
+        /// @brief Maps a level symbol to a static tile drawn from the sheet.
+        /// @param symbol Character used for the tile in level rows; also used as the tile id.
+        /// @param srcX,srcY Top-left corner of the tile in the sheet.
+        /// @param solid Whether the tile gets a collider.
+        void defineTile(char symbol, int srcX, int srcY, bool solid = true);
+
+        /// @brief Maps a level symbol to a dynamic block spawned as an entity.
+        void defineBlock(char symbol, BlockType type,
+                         CollectableType collectable = CollectableType::None);
+
+        /// @brief Fills the grid from rows of symbols, spawning entities for dynamic blocks.
+        /// @param rows One string per tile row, top to bottom. Undefined symbols are left empty.
+        /// @param count Number of rows.
+        void load(const char* const* rows, int count);
+
+        /// @brief Defines the tiles of a compiled level and copies its grid, which must match
+        /// this map's size. Its dynamic blocks are spawns, streamed by LevelStreamer.
+        void load(const LevelFile& level);
+
+        /// @brief Changes a cell; cells outside the map are ignored.
+        void set(int column, int row, std::uint8_t tile);
+        /// @brief Tile id of a cell; cells outside the map are EMPTY.
+        std::uint8_t get(int column, int row) const {
+            if (!contains(column, row))
+                return EMPTY;
+            return _tiles[static_cast<std::size_t>(row) * _columns + column];
+        }
+        bool contains(int column, int row) const {
+            return column >= 0 && column < _columns && row >= 0 && row < _rows;
+        }
+
+        int columns() const { return _columns; }
+        int rows() const { return _rows; }
+
+        /// @brief Bakes every chunk changed since the last bake into its render target.
+        void bake(SDL_Renderer* renderer);
+
+        /// @brief Marks every chunk for the next bake. Call on SDL_EVENT_RENDER_TARGETS_RESET,
+        /// which leaves the contents of render targets undefined.
+        void invalidate();
+
+        /// @brief Creates one static Box2D body holding a box per horizontal run of solid tiles.
+        /// @param boxScale Pixels per Box2D unit.
+        b2BodyId buildColliders(b2WorldId world, float boxScale) const;
+
+        /// @brief Creates one static Box2D body holding the prebuilt boxes of a compiled level.
+        static b2BodyId buildColliders(b2WorldId world, float boxScale, const LevelFile& level);
+
+        /// @brief Draws the chunks that intersect the camera view, one draw call per chunk.
+        void render(SDL_Renderer* renderer, const Position& cam, const Camera& camera) const;
+
+    private:
+        struct TileInfo {
+            bool defined = false;
+            bool solid = false;
+            bool dynamic = false;
+            SDL_FRect src = {0, 0, 0, 0};
+            BlockType block = BlockType::Solid;
+            CollectableType collectable = CollectableType::None;
+        };
+
+        struct Chunk {
+            SDL_Texture* texture = nullptr; // nullptr while the chunk has no tiles
+            int tileCount = 0;
+            bool dirty = false;
+        };
+
+        Chunk& chunkAt(int column, int row) {
+            return _chunks[static_cast<std::size_t>(row / CHUNK_TILES) * _chunkColumns + column / CHUNK_TILES];
+        }
+
+        int _columns, _rows;
+        int _chunkColumns, _chunkRows;
+        SDL_Texture* _sheet;
+
+        std::vector<std::uint8_t> _tiles;
+        std::vector<Chunk> _chunks;
+        TileInfo _info[256];
+    };
+}
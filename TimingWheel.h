@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mario {
+
+    /// @brief Hierarchical timing wheel that hands out entries when their expiry tick is reached.
+    ///
+    /// Level l holds entries due less than 64 level-l periods ahead, in the slot named by
+    /// bits 6*l..6*l+5 of the expiry. Advancing one tick empties
+    /// one level-0 slot and, when a level wraps, redistributes one slot of the level above,
+    /// so the work per tick follows the number of due entries, not the number scheduled.
+    template <class T>
+    class TimingWheel
+    {
+    public:
+        static constexpr int SLOT_BITS = 6;
+        static constexpr int SLOTS = 1 << SLOT_BITS;
+        static constexpr int LEVELS = 4; // Expiries about 2^24 ticks ahead or less are placed directly
+
+        std::uint64_t now() const { return _now; }
+
+        /// @brief Schedules t for tick expiry; expiries not after now() are due on the next tick.
+        void schedule(std::uint64_t expiry, const T& t) {
+            if (expiry <= _now)
+                expiry = _now + 1;
+            insert({expiry, t});
+        }
+
+        /// @brief Moves to the next tick and calls f(t) for every entry that expires on it.
+        template <class F>
+        void advance(F&& f) {
+            ++_now;
+            for (int l = 1; l < LEVELS && (_now & mask(l)) == 0; ++l) {
+                std::vector<Entry>& slot = _slots[l][(_now >> (SLOT_BITS*l)) & (SLOTS-1)];
+                _cascade.swap(slot);
+                for (const Entry& entry : _cascade)
+                    insert(entry);
+                _cascade.clear();
+            }
+
+            std::vector<Entry>& due = _slots[0][_now & (SLOTS-1)];
+            _expired.swap(due);
+            for (const Entry& entry : _expired)
+                f(entry.value);
+            _expired.clear();
+        }
+
+        /// @brief Drops every entry and restarts at tick 0.
+        void clear() {
+            for (auto& level : _slots)
+                for (std::vector<Entry>& slot : level)
+                    slot.clear();
+            _now = 0;
+        }
+
+    private:
+        struct Entry {
+            std::uint64_t expiry;
+            T value;
+        };
+
+        static constexpr std::uint64_t mask(int level) {
+            return (std::uint64_t{1} << (SLOT_BITS*level)) - 1;
+        }
+
+        void insert(const Entry& entry) {
+            // The lowest level on which the expiry is less than a full turn ahead
+            int level = 0;
+            while (level < LEVELS &&
+                   (entry.expiry >> (SLOT_BITS*level)) - (_now >> (SLOT_BITS*level)) >= SLOTS)
+                ++level;
+
+            std::size_t slot;
+            if (level < LEVELS) {
+                slot = (entry.expiry >> (SLOT_BITS*level)) & (SLOTS-1);
+            } else {
+                // Too far ahead: park in the top slot that is redistributed last
+                level = LEVELS-1;
+                slot = ((_now >> (SLOT_BITS*level)) - 1) & (SLOTS-1);
+            }
+            _slots[level][slot].push_back(entry);
+        }
+
+        std::uint64_t _now = 0;
+        std::vector<Entry> _slots[LEVELS][SLOTS];
+        std::vector<Entry> _cascade, _expired; // Reused so advancing does not allocate
+    };
+}
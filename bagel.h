@@ -1,20 +1,52 @@
 // Copyright (C) 2025 Moshe Sulamy
 
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
 #include <cstdlib>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#endif
+#if defined(__linux__)
+	#include <sys/mman.h>
+#endif
 
 namespace bagel
 {
+	enum class Alloc
+	{
+		Heap,		// malloc/realloc/free
+		Arena,		// linear arena, released all at once by World::reset
+		Pool,		// power-of-two block pools up to PoolBlockSize
+		HugePages,	// 2 MB pages for allocations of at least one page
+	};
+
 	struct Bagel
 	{
 		bool	DynamicResize = false;
 		int		IdBagSize = 5;
 		int		InitialEntities = 10;
+		int		MaxEntities = 1<<20;
 		int		InitialPackedSize = 5;
 		int		MaxComponents = 10;
+		Alloc	Allocator = Alloc::Heap;
+		int		ArenaBlockSize = 1<<20;
+		int		PoolBlockSize = 1<<16;
+		int		IdCacheSize = 64;
 	};
 
 	template <class T> struct Storage;
@@ -48,51 +80,380 @@ namespace bagel
 		void operator=(const NoCopy&) = delete;
 	};
 
+	class HeapAllocator final : NoInstance
+	{
+	public:
+		static void* allocate(std::size_t n) { return malloc(n); }
+		static void* reallocate(void* p, std::size_t, std::size_t n) { return realloc(p, n); }
+		static void deallocate(void* p, std::size_t) { free(p); }
+		static void reset() {}
+	};
+
+	/// Bump allocator over a chain of blocks. Freeing is a no-op except for the
+	/// most recent allocation; reset() rewinds to the first block and keeps the
+	/// blocks for reuse.
+	class ArenaAllocator final : NoInstance
+	{
+	public:
+		static void* allocate(std::size_t n) {
+			n = align(n);
+			if (_block == nullptr || _block->used + n > _block->size)
+				nextBlock(n);
+			_last = _block->data() + _block->used;
+			_block->used += n;
+			return _last;
+		}
+		static void* reallocate(void* p, std::size_t old, std::size_t n) {
+			if (p != nullptr && p == _last && _block->used - align(old) + align(n) <= _block->size) {
+				_block->used = _block->used - align(old) + align(n);
+				return p;
+			}
+			void* q = allocate(n);
+			if (p != nullptr)
+				memcpy(q, p, std::min(old, n));
+			return q;
+		}
+		static void deallocate(void* p, std::size_t n) {
+			if (p != nullptr && p == _last) {
+				_block->used -= align(n);
+				_last = nullptr;
+			}
+		}
+		static void reset() {
+			_block = _first;
+			_last = nullptr;
+			if (_block != nullptr)
+				_block->used = 0;
+		}
+	private:
+		struct alignas(std::max_align_t) Block {
+			Block*		next;
+			std::size_t	size;
+			std::size_t	used;
+			char* data() { return reinterpret_cast<char*>(this+1); }
+		};
+		static std::size_t align(std::size_t n) {
+			constexpr std::size_t a = alignof(std::max_align_t);
+			return (n + a-1) & ~(a-1);
+		}
+		static void nextBlock(std::size_t n) {
+			_last = nullptr;
+			if (_block != nullptr && _block->next != nullptr && _block->next->size >= n) {
+				_block = _block->next;
+				_block->used = 0;
+				return;
+			}
+			const std::size_t size = std::max<std::size_t>(n, Params.ArenaBlockSize);
+			Block* b = static_cast<Block*>(malloc(sizeof(Block) + size));
+			*b = {nullptr, size, 0};
+			if (_block == nullptr) {
+				_first = b;
+			} else {
+				b->next = _block->next;
+				_block->next = b;
+			}
+			_block = b;
+		}
+
+		static inline Block*	_first = nullptr;
+		static inline Block*	_block = nullptr;
+		static inline void*		_last = nullptr;
+	};
+
+	/// Free lists of fixed-size blocks, one per power of two from 64 bytes up to
+	/// PoolBlockSize. Larger requests go to the heap.
+	class PoolAllocator final : NoInstance
+	{
+	public:
+		static void* allocate(std::size_t n) {
+			const int c = sizeClass(n);
+			if (c < 0)
+				return malloc(n);
+			if (Node* node = _free[c]) {
+				_free[c] = node->next;
+				return node;
+			}
+			return carve(MinBlock << c);
+		}
+		static void* reallocate(void* p, std::size_t old, std::size_t n) {
+			if (p == nullptr)
+				return allocate(n);
+			const int oc = sizeClass(old), nc = sizeClass(n);
+			if (oc < 0 && nc < 0)
+				return realloc(p, n);
+			if (oc == nc)
+				return p;
+			void* q = allocate(n);
+			memcpy(q, p, std::min(old, n));
+			deallocate(p, old);
+			return q;
+		}
+		static void deallocate(void* p, std::size_t n) {
+			if (p == nullptr)
+				return;
+			const int c = sizeClass(n);
+			if (c < 0) {
+				free(p);
+				return;
+			}
+			Node* node = static_cast<Node*>(p);
+			node->next = _free[c];
+			_free[c] = node;
+		}
+		static void reset() {}
+	private:
+		struct Node { Node* next; };
+		static constexpr std::size_t	MinBlock = 64;
+		static constexpr std::size_t	MaxBlock = Params.PoolBlockSize;
+		static constexpr std::size_t	SlabSize = MaxBlock*4;
+		static_assert((MaxBlock & (MaxBlock-1)) == 0 && MaxBlock >= MinBlock,
+			"PoolBlockSize must be a power of two of at least 64");
+
+		static int sizeClass(std::size_t n) {
+			if (n > MaxBlock)
+				return -1;
+			int c = 0;
+			for (std::size_t s = MinBlock; s < n; s <<= 1)
+				++c;
+			return c;
+		}
+		static void* carve(std::size_t size) {
+			if (_slabLeft < size) {
+				_slab = static_cast<char*>(malloc(SlabSize));
+				_slabLeft = SlabSize;
+			}
+			void* p = _slab;
+			_slab += size;
+			_slabLeft -= size;
+			return p;
+		}
+
+		static inline Node*			_free[sizeof(std::size_t)*8] = {};
+		static inline char*			_slab = nullptr;
+		static inline std::size_t	_slabLeft = 0;
+	};
+
+	/// Allocations of at least one 2 MB page are mapped on huge pages
+	/// (MAP_HUGETLB, else transparent huge pages); smaller ones use the heap.
+	class HugePageAllocator final : NoInstance
+	{
+	public:
+		static constexpr std::size_t PageSize = std::size_t{2}<<20;
+
+		static void* allocate(std::size_t n) {
+			return n < PageSize ? malloc(n) : map(round(n));
+		}
+		static void* reallocate(void* p, std::size_t old, std::size_t n) {
+			if (p == nullptr)
+				return allocate(n);
+			if (old < PageSize && n < PageSize)
+				return realloc(p, n);
+			if (old >= PageSize && n >= PageSize && round(old) == round(n))
+				return p;
+			void* q = allocate(n);
+			memcpy(q, p, std::min(old, n));
+			deallocate(p, old);
+			return q;
+		}
+		static void deallocate(void* p, std::size_t n) {
+			if (p == nullptr)
+				return;
+			if (n < PageSize)
+				free(p);
+			else
+				unmap(p, round(n));
+		}
+		static void reset() {}
+	private:
+		static std::size_t round(std::size_t n) { return (n + PageSize-1) & ~(PageSize-1); }
+#if defined(__linux__)
+		static void* map(std::size_t n) {
+			void* p = mmap(nullptr, n, PROT_READ|PROT_WRITE,
+				MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+			if (p != MAP_FAILED)
+				return p;
+
+			// No reserved huge pages: map 2 MB aligned memory and ask for transparent huge pages
+			char* raw = static_cast<char*>(mmap(nullptr, n+PageSize, PROT_READ|PROT_WRITE,
+				MAP_PRIVATE|MAP_ANONYMOUS, -1, 0));
+			if (raw == MAP_FAILED)
+				return nullptr;
+			char* aligned = reinterpret_cast<char*>(
+				(reinterpret_cast<std::uintptr_t>(raw) + PageSize-1) & ~(PageSize-1));
+			if (aligned != raw)
+				munmap(raw, aligned-raw);
+			munmap(aligned+n, raw+PageSize-aligned);
+			madvise(aligned, n, MADV_HUGEPAGE);
+			return aligned;
+		}
+		static void unmap(void* p, std::size_t n) { munmap(p, n); }
+#else
+		static void* map(std::size_t n) { return malloc(n); }
+		static void unmap(void* p, std::size_t) { free(p); }
+#endif
+	};
+
+	using BagAllocator =
+		std::conditional_t<Params.Allocator==Alloc::Arena, ArenaAllocator,
+		std::conditional_t<Params.Allocator==Alloc::Pool, PoolAllocator,
+		std::conditional_t<Params.Allocator==Alloc::HugePages, HugePageAllocator,
+			HeapAllocator>>>;
+
+	/// Types a bag may move with memcpy when it grows. Specialize for types
+	/// that are safe to relocate bitwise without being trivially copyable.
+	template <class T>
+	struct IsRelocatable : std::is_trivially_copyable<T> {};
+
+	// Constructs from args, falling back to brace-init so aggregates can be emplaced
+	template <class T, class ...Args>
+	T* construct(void* p, Args&&... args) {
+		if constexpr (std::is_constructible_v<T, Args...>)
+			return new (p) T(std::forward<Args>(args)...);
+		else
+			return new (p) T{std::forward<Args>(args)...};
+	}
+	template <class T, class ...Args>
+	T make(Args&&... args) {
+		if constexpr (std::is_constructible_v<T, Args...>)
+			return T(std::forward<Args>(args)...);
+		else
+			return T{std::forward<Args>(args)...};
+	}
+
 	template <class T, int N>
 	class DynamicBag : NoCopy
 	{
 	public:
 		void push(const T& t) {
 			if (_size == _capacity) {
-				_capacity *= 2;
-				_arr = static_cast<T*>(
-					realloc(_arr, sizeof(T)*_capacity));
+				T copy(t);	// t may live in this bag
+				grow(_size+1);
+				new (_arr+_size) T(std::move(copy));
+			} else {
+				new (_arr+_size) T(t);
 			}
-			_arr[_size] = t;
 			++_size;
 		}
-		void ensure(size_type s) {
-			if (_capacity < s) {
-				_capacity = std::max(s, _capacity*2);
-				_arr = static_cast<T*>(
-					realloc(_arr, sizeof(T)*_capacity));
+		void push(T&& t) {
+			if (_size == _capacity) {
+				T moved(std::move(t));
+				grow(_size+1);
+				new (_arr+_size) T(std::move(moved));
+			} else {
+				new (_arr+_size) T(std::move(t));
 			}
+			++_size;
+		}
+		template <class ...Args>
+		T& emplace(Args&&... args) {
+			ensure(_size+1);
+			T* t = construct<T>(_arr+_size, std::forward<Args>(args)...);
+			++_size;
+			return *t;
+		}
+		void push(const T& t, size_type n) {
+			ensure(_size + n);
+			for (size_type i = 0; i < n; ++i)
+				new (_arr+_size++) T(t);
+		}
+		void ensure(size_type s) {
+			if (_capacity < s)
+				grow(s);
+		}
+		/// Grows the bag to at least s elements, value-initializing new ones.
+		void resize(size_type s) {
+			ensure(s);
+			for (; _size < s; ++_size)
+				new (_arr+_size) T();
+		}
+		T pop() {
+			T t = std::move(_arr[--_size]);
+			_arr[_size].~T();
+			return t;
 		}
-		T pop() { return _arr[--_size]; }
 		T& operator[](index_type i) { return _arr[i]; }
 		const T& operator[](index_type i) const { return _arr[i]; }
-		void clear() { _size = 0; }
+		const T* data() const { return _arr; }
+		void clear() {
+			destroy();
+			_size = 0;
+		}
 
 		size_type size() const { return _size; }
 		size_type capacity() const { return _capacity; }
+		size_type growths() const { return _growths; }
+
+		void release() {
+			destroy();
+			BagAllocator::deallocate(_arr, sizeof(T)*_capacity);
+			_arr = nullptr;
+			_size = 0;
+			_capacity = 0;
+		}
 
-		~DynamicBag() { free(_arr); }
+		~DynamicBag() {
+			destroy();
+			BagAllocator::deallocate(_arr, sizeof(T)*_capacity);
+		}
 	private:
-		T*			_arr = static_cast<T*>(malloc(sizeof(T) * N));
+		void grow(size_type s) {
+			const size_type capacity = std::max({s, _capacity*2, N});
+			if constexpr (IsRelocatable<T>::value) {
+				_arr = static_cast<T*>(BagAllocator::reallocate(
+					_arr, sizeof(T)*_capacity, sizeof(T)*capacity));
+			} else {
+				T* arr = static_cast<T*>(BagAllocator::allocate(sizeof(T)*capacity));
+				for (size_type i = 0; i < _size; ++i) {
+					new (arr+i) T(std::move(_arr[i]));
+					_arr[i].~T();
+				}
+				BagAllocator::deallocate(_arr, sizeof(T)*_capacity);
+				_arr = arr;
+			}
+			_capacity = capacity;
+			++_growths;
+		}
+		void destroy() {
+			if constexpr (!std::is_trivially_destructible_v<T>)
+				for (size_type i = 0; i < _size; ++i)
+					_arr[i].~T();
+		}
+
+		T*			_arr = nullptr;
 		size_type	_size = 0;
-		size_type	_capacity = N;
+		size_type	_capacity = 0;
+		size_type	_growths = 0;
 	};
 	template <class T, int N>
 	class StaticBag
 	{
 	public:
 		void push(const T& t) { _arr[_size++] = t; }
-		T pop() { return _arr[--_size]; }
+		void push(T&& t) { _arr[_size++] = std::move(t); }
+		template <class ...Args>
+		T& emplace(Args&&... args) {
+			// Slots are always constructed; replace the one past the end in place
+			T* slot = _arr+_size;
+			slot->~T();
+			T* t = construct<T>(slot, std::forward<Args>(args)...);
+			++_size;
+			return *t;
+		}
+		void push(const T& t, size_type n) {
+			for (size_type i = 0; i < n; ++i)
+				_arr[_size++] = t;
+		}
+		void resize(size_type s) { _size = std::max(_size, s); }
+		T pop() { return std::move(_arr[--_size]); }
 		T& operator[](index_type i) { return _arr[i]; }
 		const T& operator[](index_type i) const { return _arr[i]; }
+		const T* data() const { return _arr; }
 		void clear() { _size = 0; }
+		void release() { _size = 0; }
 
 		size_type size() const { return _size; }
+		static constexpr size_type capacity() { return N; }
+		static constexpr size_type growths() { return 0; }
 		static void ensure(size_type) {}
 	private:
 		T			_arr[N];
@@ -101,16 +462,57 @@ namespace bagel
 	template <class T, int N>
 	using Bag = std::conditional_t<Params.DynamicResize, DynamicBag<T, N>, StaticBag<T,N>>;
 
+	struct StorageStats
+	{
+		const char*	storage = "";		// Storage kind
+		size_type	count = 0;			// Entities holding the component
+		size_type	capacity = 0;		// Components that fit without growing
+		std::size_t	usedBytes = 0;		// Bytes holding live components
+		std::size_t	reservedBytes = 0;	// Bytes allocated for components
+		std::size_t	indexBytes = 0;		// Bytes of the entity-to-component index
+		size_type	growths = 0;		// Reallocations so far
+	};
+
+	inline id_type maxOf(const ent_type* es, size_type n) {
+		id_type m = -1;
+		for (size_type i = 0; i < n; ++i)
+			m = std::max(m, es[i].id);
+		return m;
+	}
+
 	template <class T>
 	class SparseStorage final : NoInstance
 	{
 	public:
 		static void add(ent_type e, const T& t) {
-			_bag.ensure(e.id);
+			_bag.resize(e.id+1);
 			_bag[e.id] = t;
 		}
-		static void del(ent_type) {}
+		static void add(ent_type e, T&& t) {
+			_bag.resize(e.id+1);
+			_bag[e.id] = std::move(t);
+		}
+		template <class ...Args>
+		static void emplace(ent_type e, Args&&... args) {
+			_bag.resize(e.id+1);
+			_bag[e.id] = make<T>(std::forward<Args>(args)...);
+		}
+		static void add(const ent_type* es, size_type n, const T& t) {
+			_bag.resize(maxOf(es, n)+1);
+			for (size_type i = 0; i < n; ++i)
+				_bag[es[i].id] = t;
+		}
+		static void del(ent_type e) {
+			// Release what the component owns; trivial slots are simply left behind
+			if constexpr (!std::is_trivially_destructible_v<T>)
+				_bag[e.id] = T();
+		}
 		static T& get(ent_type e) { return _bag[e.id]; }
+		static void reset() { _bag.release(); }
+		static StorageStats stats(size_type count) {
+			return {"Sparse", count, _bag.capacity(),
+				sizeof(T)*count, sizeof(T)*_bag.capacity(), 0, _bag.growths()};
+		}
 	private:
 		static inline Bag<T,Params.InitialEntities> _bag;
 	};
@@ -119,18 +521,45 @@ namespace bagel
 	{
 	public:
 		static void add(ent_type e, const T& t) {
-			_entToComp.ensure(e.id);
+			_entToComp.resize(e.id+1);
 			_entToComp[e.id] = _comps.size();
 			_comps.push(t);
 			_compToEnt.push(e);
 		}
+		static void add(ent_type e, T&& t) {
+			_entToComp.resize(e.id+1);
+			_entToComp[e.id] = _comps.size();
+			_comps.push(std::move(t));
+			_compToEnt.push(e);
+		}
+		template <class ...Args>
+		static void emplace(ent_type e, Args&&... args) {
+			_entToComp.resize(e.id+1);
+			_entToComp[e.id] = _comps.size();
+			_comps.emplace(std::forward<Args>(args)...);
+			_compToEnt.push(e);
+		}
+		static void add(const ent_type* es, size_type n, const T& t) {
+			_entToComp.resize(maxOf(es, n)+1);
+			_compToEnt.ensure(_compToEnt.size()+n);
+			for (size_type i = 0; i < n; ++i) {
+				_entToComp[es[i].id] = _comps.size()+i;
+				_compToEnt.push(es[i]);
+			}
+			_comps.push(t, n);
+		}
 		static void del(ent_type e) {
 			index_type ent_comp_idx = _entToComp[e.id];
-			ent_type last_ent = _compToEnt.pop();
+			index_type last_idx = _comps.size()-1;
 
-			_comps[ent_comp_idx] = _comps.pop();
-			_compToEnt[ent_comp_idx] = last_ent;
-			_entToComp[last_ent.id] = ent_comp_idx;
+			if (ent_comp_idx != last_idx) {
+				ent_type last_ent = _compToEnt[last_idx];
+				_comps[ent_comp_idx] = std::move(_comps[last_idx]);
+				_compToEnt[ent_comp_idx] = last_ent;
+				_entToComp[last_ent.id] = ent_comp_idx;
+			}
+			_comps.pop();
+			_compToEnt.pop();
 		}
 		static T& get(ent_type e) {
 			return _comps[_entToComp[e.id]];
@@ -142,18 +571,117 @@ namespace bagel
 		static ent_type entity(index_type idx) {
 			return _compToEnt[idx];
 		}
+		static index_type index(ent_type e) {
+			return _entToComp[e.id];
+		}
+		static bool has(ent_type e) {
+			if (e.id >= _entToComp.size())
+				return false;
+			const index_type idx = _entToComp[e.id];
+			return idx >= 0 && idx < _comps.size() && _compToEnt[idx].id == e.id;
+		}
+
+		/// Reorders the components so that cmp(a,b) holds for consecutive ones.
+		template <class Compare>
+		static void sort(Compare cmp) {
+			const size_type n = _comps.size();
+			bool sorted = true;
+			for (index_type i = 1; i < n && sorted; ++i)
+				sorted = !cmp(_comps[i], _comps[i-1]);
+			if (sorted)
+				return;
+
+			_order.resize(n);
+			for (index_type i = 0; i < n; ++i)
+				_order[i] = i;
+			std::stable_sort(_order.begin(), _order.end(), [&](index_type a, index_type b) {
+				return cmp(_comps[a], _comps[b]);
+			});
+			permute();
+		}
+
+		/// Reorders the components to follow the entity order of packed storage S.
+		/// Entities missing from S keep their relative order after the others.
+		template <class S>
+		static void sortAs() {
+			const size_type n = _comps.size();
+			_order.clear();
+			_placed.assign(n, false);
+			for (index_type i = 0; i < S::size(); ++i) {
+				const ent_type e = S::entity(i);
+				if (has(e)) {
+					_order.push_back(_entToComp[e.id]);
+					_placed[_entToComp[e.id]] = true;
+				}
+			}
+			for (index_type i = 0; i < n; ++i)
+				if (!_placed[i])
+					_order.push_back(i);
+			permute();
+		}
+		static void reset() {
+			_comps.release();
+			_entToComp.release();
+			_compToEnt.release();
+		}
+		static StorageStats stats(size_type count) {
+			return {"Packed", count, _comps.capacity(),
+				(sizeof(T)+sizeof(ent_type))*_comps.size(),
+				sizeof(T)*_comps.capacity() + sizeof(ent_type)*_compToEnt.capacity(),
+				sizeof(index_type)*_entToComp.capacity(),
+				_comps.growths() + _compToEnt.growths() + _entToComp.growths()};
+		}
 	private:
+		// Moves the component at _order[i] to i, following each permutation cycle
+		// with a single temporary, then re-points the entity index in one pass
+		static void permute() {
+			const size_type n = _comps.size();
+			_placed.assign(n, false);
+			for (index_type start = 0; start < n; ++start) {
+				if (_placed[start] || _order[start] == start)
+					continue;
+
+				T comp = std::move(_comps[start]);
+				const ent_type ent = _compToEnt[start];
+				index_type cur = start;
+				for (;;) {
+					_placed[cur] = true;
+					const index_type next = _order[cur];
+					if (next == start) {
+						_comps[cur] = std::move(comp);
+						_compToEnt[cur] = ent;
+						break;
+					}
+					_comps[cur] = std::move(_comps[next]);
+					_compToEnt[cur] = _compToEnt[next];
+					cur = next;
+				}
+			}
+			for (index_type i = 0; i < n; ++i)
+				_entToComp[_compToEnt[i].id] = i;
+		}
+
 		static inline Bag<T,Params.InitialPackedSize>			_comps;
 		static inline Bag<index_type,Params.InitialEntities>	_entToComp;
 		static inline Bag<ent_type,Params.InitialPackedSize>	_compToEnt;
+		static inline std::vector<index_type>					_order;
+		static inline std::vector<bool>							_placed;
 	};
 	template <class T>
 	class TaggedStorage final : NoInstance
 	{
 	public:
 		static void add(ent_type, const T&) {}
+		static void add(ent_type, T&&) {}
+		template <class ...Args>
+		static void emplace(ent_type, Args&&...) {}
+		static void add(const ent_type*, size_type, const T&) {}
 		static void del(ent_type) {}
 		static T& get(ent_type) = delete;
+		static void reset() {}
+		static StorageStats stats(size_type count) {
+			return {"Tagged", count, 0, 0, 0, 0, 0};
+		}
 	};
 
 	template <class T>
@@ -165,7 +693,7 @@ namespace bagel
 	{
 	public:
 		using bit_type = mask_type;
-		static constexpr bit_type bit(index_type idx) { return 1<<idx; }
+		static constexpr bit_type bit(index_type idx) { return bit_type{1}<<idx; }
 
 		void set(const bit_type b) { _mask |= b; }
 
@@ -185,7 +713,7 @@ namespace bagel
 			const mask_type		mask;
 		};
 		static constexpr bit_type bit(index_type idx) {
-			return {idx/BitsetWidth, static_cast<mask_type>(1<<(idx%BitsetWidth))};
+			return {idx/BitsetWidth, static_cast<mask_type>(mask_type{1}<<(idx%BitsetWidth))};
 		}
 
 		void set(const bit_type& b) { _masks[b.index] |= b.mask; }
@@ -206,41 +734,766 @@ namespace bagel
 	};
 	using Mask = std::conditional_t<Params.MaxComponents<=BitsetWidth, SingleMask, MultiMask>;
 
-	static inline index_type compCounter = -1;
-	template <class>
+	template <class T>
+	const char* typeName() {
+#if defined(__clang__) || defined(__GNUC__)
+		static const std::string name = [](const std::string& sig) {
+			const std::size_t start = sig.find("T = ") + 4;
+			return sig.substr(start, sig.find_first_of(";]", start) - start);
+		}(__PRETTY_FUNCTION__);
+#else
+		static const std::string name = __FUNCSIG__;
+#endif
+		return name.c_str();
+	}
+
+	struct ComponentInfo
+	{
+		const char*		name;
+		std::size_t		size;
+		bool			empty;		// Holds no data, so only presence matters
+		void			(*reset)();
+		void			(*del)(ent_type);
+		StorageStats	(*stats)(size_type);
+	};
+	inline index_type compCounter = -1;
+	inline ComponentInfo componentInfo[Params.MaxComponents] = {};
+
+	template <class T>
+	index_type registerComponent() {
+		const index_type idx = ++compCounter;
+		if (idx >= Params.MaxComponents) {
+			std::fprintf(stderr, "bagel: registering %s exceeds Params.MaxComponents (%d)\n",
+				typeName<T>(), static_cast<int>(Params.MaxComponents));
+			std::abort();
+		}
+		componentInfo[idx] = {typeName<T>(), sizeof(T), std::is_empty_v<T>,
+			&Storage<T>::type::reset, &Storage<T>::type::del, &Storage<T>::type::stats};
+		return idx;
+	}
+
+	template <class T>
 	struct Component final : NoInstance
 	{
-		static inline const index_type		Index = ++compCounter;
+		static inline const index_type		Index = registerComponent<T>();
 		static inline const Mask::bit_type	Bit = Mask::bit(Index);
 	};
 
+	/// Two-level set of entity ids: one bit per entity, plus one summary bit per
+	/// 64-entity word that is set while the word is non-zero.
+	class EntityBitset
+	{
+	public:
+		using word_type = std::uint64_t;
+		static constexpr size_type WordBits = 64;
+		static constexpr size_type GroupWords = 4;
+
+		void set(id_type id) {
+			const index_type w = id/WordBits;
+			if (w >= _words.size())
+				grow(w);
+			_words[w] |= word_type{1} << (id%WordBits);
+			_summary[w/WordBits] |= word_type{1} << (w%WordBits);
+		}
+		void clear(id_type id) {
+			const index_type w = id/WordBits;
+			if (w >= _words.size())
+				return;
+			_words[w] &= ~(word_type{1} << (id%WordBits));
+			if (_words[w] == 0)
+				_summary[w/WordBits] &= ~(word_type{1} << (w%WordBits));
+		}
+		bool test(id_type id) const {
+			const index_type w = id/WordBits;
+			return w < _words.size() && (_words[w] >> (id%WordBits)) & 1;
+		}
+
+		size_type words() const { return _words.size(); }
+		size_type summaries() const { return _summary.size(); }
+		std::size_t bytes() const {
+			return sizeof(word_type)*(_words.capacity() + _summary.capacity());
+		}
+		size_type count() const {
+			size_type c = 0;
+			for (index_type i = 0; i < _words.size(); ++i)
+				c += __builtin_popcountll(_words[i]);
+			return c;
+		}
+		void release() {
+			_words.release();
+			_summary.release();
+		}
+		const word_type* wordData() const { return _words.data(); }
+		const word_type* summaryData() const { return _summary.data(); }
+	private:
+		// Word count is kept a multiple of GroupWords so groups can be loaded whole
+		void grow(index_type w) {
+			const size_type words = (w/GroupWords + 1)*GroupWords;
+			_words.push(0, words - _words.size());
+			const size_type summaries = (words-1)/WordBits + 1;
+			if (summaries > _summary.size())
+				_summary.push(0, summaries - _summary.size());
+		}
+
+		static constexpr int InitialWords = (Params.InitialEntities/WordBits + 1)*GroupWords;
+		Bag<word_type, InitialWords>					_words;
+		Bag<word_type, InitialWords/WordBits + 1>		_summary;
+	};
+
+	/// Fixed set of worker threads running indexed tasks. Each participant
+	/// starts with an even slice of the tasks and steals half of another
+	/// participant's remaining slice when its own runs out.
+	class ThreadPool final : NoCopy
+	{
+	public:
+		explicit ThreadPool(size_type threads = std::max(1u, std::thread::hardware_concurrency()))
+			: _slices(new Slice[threads]) {
+			for (size_type i = 0; i < threads-1; ++i)
+				_workers.emplace_back([this, i] { loop(i); });
+		}
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (std::thread& t : _workers)
+				t.join();
+		}
+
+		static ThreadPool& shared() {
+			static ThreadPool pool;
+			return pool;
+		}
+
+		/// Participants, including the thread that calls run.
+		size_type threads() const { return static_cast<size_type>(_workers.size())+1; }
+
+		/// Calls f(task) for every task in [0, tasks) and returns when all are done.
+		/// Not reentrant: f must not call run.
+		template <class F>
+		void run(size_type tasks, F&& f) {
+			std::lock_guard<std::mutex> running(_running);
+			const size_type n = threads();
+			for (size_type i = 0; i < n; ++i)
+				_slices[i].range.store(pack(tasks*i/n, tasks*(i+1)/n));
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_ctx = &f;
+				_fn = [](void* ctx, size_type task) { (*static_cast<std::remove_reference_t<F>*>(ctx))(task); };
+				_busy = n-1;
+				++_generation;
+			}
+			_wake.notify_all();
+
+			work(n-1);
+
+			std::unique_lock<std::mutex> lock(_mutex);
+			_done.wait(lock, [this] { return _busy == 0; });
+		}
+	private:
+		struct alignas(64) Slice { std::atomic<std::uint64_t> range{0}; };
+
+		static std::uint64_t pack(size_type lo, size_type hi) {
+			return std::uint64_t(std::uint32_t(lo)) << 32 | std::uint32_t(hi);
+		}
+
+		void loop(size_type self) {
+			std::uint64_t seen = 0;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_wake.wait(lock, [&] { return _stop || _generation != seen; });
+					if (_stop)
+						return;
+					seen = _generation;
+				}
+				work(self);
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					--_busy;
+				}
+				_done.notify_one();
+			}
+		}
+
+		void work(size_type self) {
+			size_type task;
+			while (pop(self, task) || steal(self, task))
+				_fn(_ctx, task);
+		}
+
+		bool pop(size_type self, size_type& task) {
+			std::atomic<std::uint64_t>& range = _slices[self].range;
+			std::uint64_t r = range.load();
+			for (;;) {
+				const size_type lo = r >> 32, hi = r & 0xFFFFFFFF;
+				if (lo >= hi)
+					return false;
+				if (range.compare_exchange_weak(r, pack(lo+1, hi))) {
+					task = lo;
+					return true;
+				}
+			}
+		}
+
+		bool steal(size_type self, size_type& task) {
+			const size_type n = threads();
+			for (size_type k = 1; k < n; ++k) {
+				std::atomic<std::uint64_t>& range = _slices[(self+k)%n].range;
+				std::uint64_t r = range.load();
+				for (;;) {
+					const size_type lo = r >> 32, hi = r & 0xFFFFFFFF;
+					if (lo >= hi)
+						break;
+					const size_type mid = hi - (hi-lo+1)/2;
+					if (range.compare_exchange_weak(r, pack(lo, mid))) {
+						_slices[self].range.store(pack(mid+1, hi));
+						task = mid;
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		std::unique_ptr<Slice[]>	_slices;
+		std::vector<std::thread>	_workers;
+		std::mutex					_running;
+		std::mutex					_mutex;
+		std::condition_variable		_wake;
+		std::condition_variable		_done;
+		std::uint64_t				_generation = 0;
+		size_type					_busy = 0;
+		bool						_stop = false;
+		void*						_ctx = nullptr;
+		void						(*_fn)(void*, size_type) = nullptr;
+	};
+
+	struct ComponentReport
+	{
+		index_type		index;
+		const char*		name;
+		std::size_t		componentSize;
+		StorageStats	storage;
+	};
+
+	/// Memory and occupancy of the world and each registered component.
+	/// Iterating the report visits the components in index order.
+	struct WorldReport
+	{
+		size_type		entities;		// Live entities
+		size_type		freeIds;		// Destroyed ids waiting for reuse
+		id_type			maxId;
+		std::size_t		maskBytes;		// Bytes reserved for entity masks and their page directory
+		std::size_t		columnBytes;	// Bytes reserved for per-component entity bitsets
+		size_type		maskGrowths;	// Times the mask table grew since the last reset
+		size_type		componentCount;
+		ComponentReport	components[Params.MaxComponents];
+
+		const ComponentReport* begin() const { return components; }
+		const ComponentReport* end() const { return components + componentCount; }
+	};
+
+#if defined(BAGEL_PROFILE_STORAGE)
+	struct AccessCounters
+	{
+		std::atomic<std::uint64_t>	gets{0};
+		std::atomic<std::uint64_t>	sequential{0};	// Gets at most SequentialWindow ids after the previous one
+		std::atomic<std::uint64_t>	adds{0};
+		std::atomic<std::uint64_t>	dels{0};
+		std::atomic<size_type>		live{0};
+		std::atomic<size_type>		peakLive{0};
+		std::atomic<id_type>		peakMaxId{0};
+	};
+
+	/// Records how each component is accessed through World and recommends a
+	/// storage per component. Enabled by defining BAGEL_PROFILE_STORAGE; the
+	/// recommendations are printed to stderr at exit as bagel_cfg.h lines.
+	class StorageProfiler final : NoInstance
+	{
+	public:
+		static constexpr bool Enabled = true;
+		static constexpr id_type SequentialWindow = 8;	// Ids ahead of the previous get that count as sequential
+
+		static void get(index_type c, id_type id) {
+			thread_local id_type last[Params.MaxComponents] = {};
+			Counters& k = _counters[c];
+			k.gets.fetch_add(1, std::memory_order_relaxed);
+			const id_type step = id - last[c];
+			if (step >= 0 && step <= SequentialWindow)
+				k.sequential.fetch_add(1, std::memory_order_relaxed);
+			last[c] = id;
+		}
+		static void add(index_type c, id_type id, bool had) {
+			static const bool atExit = (std::atexit(&print), true);
+			(void)atExit;
+			Counters& k = _counters[c];
+			k.adds.fetch_add(1, std::memory_order_relaxed);
+			if (!had)
+				raise(k.peakLive, k.live.fetch_add(1, std::memory_order_relaxed)+1);
+			raise(k.peakMaxId, id);
+		}
+		static void del(index_type c, bool had) {
+			if (!had)
+				return;
+			Counters& k = _counters[c];
+			k.dels.fetch_add(1, std::memory_order_relaxed);
+			k.live.fetch_sub(1, std::memory_order_relaxed);
+		}
+		// World::reset dropped every component; the next world is profiled afresh
+		static void reset() {
+			for (Counters& k : _counters) {
+				k.gets.store(0, std::memory_order_relaxed);
+				k.sequential.store(0, std::memory_order_relaxed);
+				k.adds.store(0, std::memory_order_relaxed);
+				k.dels.store(0, std::memory_order_relaxed);
+				k.live.store(0, std::memory_order_relaxed);
+				k.peakLive.store(0, std::memory_order_relaxed);
+				k.peakMaxId.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		/// One BAGEL_STORAGE line per registered component, annotated with the
+		/// observed access pattern and the estimated memory and iteration cost
+		/// (cache lines per pass) of the current and recommended storage.
+		static std::string report() {
+			std::string out = "// Storage recommendations from BAGEL_PROFILE_STORAGE\n";
+			char line[512];
+			for (index_type c = 0; c <= compCounter; ++c) {
+				const ComponentInfo& info = componentInfo[c];
+				const Counters& k = _counters[c];
+				const double ids = k.peakMaxId.load()+1.0, live = k.peakLive.load();
+				const double gets = k.gets.load();
+				const double seq = gets > 0 ? k.sequential.load()/gets : 1;
+
+				const Cost sparse = sparseCost(info, ids, live);
+				const Cost packed = packedCost(info, ids, live, seq);
+				const char* current = info.stats(0).storage;
+				const char* pick;
+				Cost was, now;
+				if (info.empty) {
+					pick = "Tagged";
+					now = {0, 0};
+				} else if (packed.bytes < sparse.bytes && (seq >= 0.5 || live/ids < 0.125)) {
+					// Packed adds an indirection to every get, so it only pays off for
+					// random access when the component is rare
+					pick = "Packed";
+					now = packed;
+				} else {
+					pick = "Sparse";
+					now = sparse;
+				}
+				was = std::strcmp(current, "Packed") == 0 ? packed
+					: std::strcmp(current, "Tagged") == 0 ? Cost{0, 0} : sparse;
+
+				std::snprintf(line, sizeof(line),
+					"BAGEL_STORAGE(%s,%sStorage)\t// %.0f%% of ids, %.0f gets (%.0f%% sequential), "
+					"%llu adds, %llu dels; memory %.0f -> %.0f KiB, iteration %.0f -> %.0f lines\n",
+					info.name, pick, 100*live/ids, gets, 100*seq,
+					static_cast<unsigned long long>(k.adds.load()),
+					static_cast<unsigned long long>(k.dels.load()),
+					was.bytes/1024, now.bytes/1024, was.lines, now.lines);
+				out += line;
+			}
+			return out;
+		}
+
+	private:
+		using Counters = AccessCounters;
+		struct Cost
+		{
+			double	bytes;
+			double	lines;
+		};
+		static constexpr double Line = 64;
+
+		static void raise(std::atomic<size_type>& peak, size_type v) {
+			int p = peak.load(std::memory_order_relaxed);
+			while (v > p && !peak.compare_exchange_weak(p, v, std::memory_order_relaxed)) {}
+		}
+
+		// One slot per id; a pass touches each live entity's line, at most every line once
+		static Cost sparseCost(const ComponentInfo& info, double ids, double live) {
+			const double bytes = ids*info.size;
+			return {bytes, std::min(live, bytes/Line)};
+		}
+		// Dense components plus an id-to-index table and the owning entity of each slot;
+		// random gets miss the dense array once each
+		static Cost packedCost(const ComponentInfo& info, double ids, double live, double seq) {
+			const double dense = live*(info.size + sizeof(ent_type));
+			const double index = ids*sizeof(index_type);
+			const double lines = std::min(live, index/Line) + seq*dense/Line + (1-seq)*live;
+			return {dense + index, lines};
+		}
+
+		static void print() {
+			std::fputs(report().c_str(), stderr);
+		}
+
+		static inline Counters _counters[Params.MaxComponents];
+	};
+#else
+	class StorageProfiler final : NoInstance
+	{
+	public:
+		static constexpr bool Enabled = false;
+
+		static void get(index_type, id_type) {}
+		static void add(index_type, id_type, bool) {}
+		static void del(index_type, bool) {}
+		static void reset() {}
+		static std::string report() { return {}; }
+	};
+#endif
+
+	/// Entity masks in fixed-size pages that never move, so the table can grow
+	/// while other threads hand out ids and write masks. The directory of pages
+	/// is sized for Params.MaxEntities.
+	class MaskPages final : NoCopy
+	{
+	public:
+		static constexpr size_type PageBits = 10;
+		static constexpr size_type PageSize = 1<<PageBits;
+		static constexpr size_type MaxPages = (Params.MaxEntities + PageSize-1)/PageSize;
+		static constexpr std::size_t DirectoryBytes = sizeof(std::atomic<Mask*>)*MaxPages;
+
+		Mask& operator[](id_type id) {
+			return _pages[id>>PageBits].load(std::memory_order_acquire)[id&(PageSize-1)];
+		}
+		const Mask& operator[](id_type id) const {
+			return _pages[id>>PageBits].load(std::memory_order_acquire)[id&(PageSize-1)];
+		}
+
+		/// Makes sure ids up to last have a mask; new masks are empty. Thread-safe.
+		void ensure(id_type last) {
+			if (last < _capacity.load(std::memory_order_acquire))
+				return;
+			std::lock_guard<std::mutex> lock(_grow);
+			if (last < _capacity.load())
+				return;
+			if (last/PageSize >= MaxPages) {
+				std::fprintf(stderr, "bagel: entity %d exceeds Params.MaxEntities (%d)\n",
+					static_cast<int>(last), static_cast<int>(Params.MaxEntities));
+				std::abort();
+			}
+			++_growths;
+			for (size_type p = _capacity.load()/PageSize; p <= last/PageSize; ++p) {
+				Mask* page = static_cast<Mask*>(BagAllocator::allocate(sizeof(Mask)*PageSize));
+				for (size_type i = 0; i < PageSize; ++i)
+					new (page+i) Mask{};
+				_pages[p].store(page, std::memory_order_release);
+				_capacity.store((p+1)*PageSize, std::memory_order_release);
+			}
+		}
+
+		size_type pages() const { return _capacity.load()/PageSize; }
+		/// Bytes of the mask pages and of the page directory.
+		std::size_t bytes() const { return sizeof(Mask)*_capacity.load() + DirectoryBytes; }
+		/// Times ensure() had to add pages since the last release().
+		size_type growths() const { return _growths.load(); }
+
+		void release() {
+			for (size_type p = 0; p < pages(); ++p)
+				BagAllocator::deallocate(_pages[p].exchange(nullptr), sizeof(Mask)*PageSize);
+			_capacity = 0;
+			_growths = 0;
+		}
+
+	private:
+		std::atomic<Mask*>		_pages[MaxPages] = {};
+		std::atomic<id_type>	_capacity{0};		// Ids with a mask; always whole pages
+		std::atomic<size_type>	_growths{0};
+		std::mutex				_grow;
+	};
+
+	// Ids a thread holds for World::createEntityConcurrent
+	struct EntityIdCache
+	{
+		unsigned	epoch = 0;		// World::reset generation the ids belong to
+		size_type	count = 0;
+		ent_type	ids[Params.IdCacheSize];
+	};
+
+	/// Entities that hold a set of components, kept in a dense list that World
+	/// updates as components are added, deleted and entities destroyed. Only
+	/// changes to components in the query's mask touch it, and iterating costs
+	/// no matching. The list is in no particular order.
+	class QueryBase : NoCopy
+	{
+	public:
+		size_type size() const { return static_cast<size_type>(_list.size()); }
+		const ent_type* begin() const { return _list.data(); }
+		const ent_type* end() const { return _list.data() + _list.size(); }
+		const Mask& mask() const { return _mask; }
+		bool has(ent_type e) const {
+			return e.id < static_cast<id_type>(_pos.size()) && _pos[e.id] >= 0;
+		}
+
+		/// Calls f(ent_type) for every match. f may remove its own entity from
+		/// the query; other structural changes belong in a CommandBuffer.
+		template <class F>
+		void forEach(F&& f) const {
+			for (size_type i = size(); i-- > 0;)
+				f(_list[i]);
+		}
+		/// Records the entities that join the query from now on, starting with
+		/// the current matches, so a system can index the matches incrementally.
+		void trackAdded() {
+			_tracking = true;
+			_added.assign(_list.begin(), _list.end());
+		}
+		/// Calls f(ent_type) for every entity that joined since the last call
+		/// and forgets them. An entity may have left the query again since.
+		template <class F>
+		void takeAdded(F&& f) {
+			for (const ent_type e : _added)
+				f(e);
+			_added.clear();
+		}
+
+		/// Calls f(ent_type) for every match on the threads of the shared pool.
+		/// f must not change which entities match.
+		template <class F>
+		void parallelForEach(F&& f) const {
+			constexpr size_type Chunk = 256;
+			ThreadPool& pool = ThreadPool::shared();
+			const size_type tasks = (size() + Chunk-1)/Chunk;
+			if (tasks <= 1) {
+				forEach(f);
+				return;
+			}
+			pool.run(tasks, [this, &f](size_type t) {
+				const size_type last = std::min(size(), (t+1)*Chunk);
+				for (size_type i = t*Chunk; i < last; ++i)
+					f(_list[i]);
+			});
+		}
+
+	protected:
+		QueryBase(const index_type* indices, size_type count);
+		~QueryBase();
+
+	private:
+		friend class World;
+
+		void insert(ent_type e) {
+			if (e.id >= static_cast<id_type>(_pos.size()))
+				_pos.resize(e.id+1, -1);
+			_pos[e.id] = size();
+			_list.push_back(e);
+			if (_tracking)
+				_added.push_back(e);
+		}
+		void erase(ent_type e) {
+			const index_type i = _pos[e.id];
+			_list[i] = _list.back();
+			_pos[_list[i].id] = i;
+			_list.pop_back();
+			_pos[e.id] = -1;
+		}
+		void clear() {
+			_list.clear();
+			_pos.clear();
+			_added.clear();
+		}
+
+		Mask					_mask;
+		std::vector<ent_type>	_list;
+		std::vector<index_type>	_pos;							// Index in _list by entity id, -1 if absent
+		std::vector<ent_type>	_added;							// Joined since the last takeAdded
+		bool					_tracking = false;
+		index_type				_indices[Params.MaxComponents];
+		size_type				_count;
+		QueryBase*				_next = nullptr;				// In World's list of every query
+		QueryBase*				_nextFor[Params.MaxComponents];	// In World's list per component
+	};
+
+	/// Query over the entities that hold all of Ts. Component indices are
+	/// assigned during static initialization, so construct queries after it,
+	/// e.g. as function-local statics.
+	template <class T, class ...Ts>
+	class Query final : public QueryBase
+	{
+	public:
+		Query() : QueryBase(indices(), 1+sizeof...(Ts)) {}
+	private:
+		static const index_type* indices() {
+			static const index_type idx[] = {Component<T>::Index, Component<Ts>::Index...};
+			return idx;
+		}
+	};
+
+	template <class ...Ts> class Prefab;
+
 	class World final : NoInstance
 	{
 	public:
 		static ent_type createEntity() {
 			if (_ids.size() > 0)
 				return _ids.pop();
-			_masks.push(Mask{});
-			return {++_maxId.id};
+			const id_type id = _maxId.load(std::memory_order_relaxed)+1;
+			_masks.ensure(id);
+			_maxId.store(id, std::memory_order_relaxed);
+			return {id};
+		}
+		static void createEntities(ent_type* out, size_type n, const Mask& m) {
+			size_type i = 0;
+			for (; i < n && _ids.size() > 0; ++i)
+				out[i] = _ids.pop();
+			const id_type first = _maxId.load(std::memory_order_relaxed)+1;
+			_masks.ensure(first+n-i-1);
+			_maxId.store(first+n-i-1, std::memory_order_relaxed);
+			for (id_type id = first; i < n; ++i)
+				out[i] = {id++};
+			for (i = 0; i < n; ++i)
+				_masks[out[i].id] = m;
 		}
+
+		/// Like createEntity, but safe to call from several threads at once, e.g.
+		/// inside parallelForEach. It must not overlap the single-threaded calls
+		/// that create, destroy or reset. Each thread caches up to
+		/// Params.IdCacheSize ids, recycled ones first, and otherwise reserves a
+		/// fresh range from maxId; only cache refills take a lock.
+		static ent_type createEntityConcurrent() {
+			IdCache& cache = _cache;
+			if (cache.count == 0 || cache.epoch != _epoch.load(std::memory_order_relaxed))
+				refill(cache);
+			return cache.ids[--cache.count];
+		}
+		/// Creates n entities without components; thread-safe like createEntityConcurrent.
+		static void createEntitiesConcurrent(ent_type* out, size_type n) {
+			IdCache& cache = _cache;
+			if (cache.epoch != _epoch.load(std::memory_order_relaxed))
+				refill(cache);
+			size_type i = 0;
+			for (; i < n && cache.count > 0; ++i)
+				out[i] = cache.ids[--cache.count];
+			if (i == n)
+				return;
+			const id_type first = _maxId.fetch_add(n-i)+1;
+			_masks.ensure(first+n-i-1);
+			for (id_type id = first; i < n; ++i)
+				out[i] = {id++};
+		}
+		/// Returns the ids cached by the calling thread for reuse. Until then they
+		/// count as live entities.
+		static void flushIdCache() {
+			IdCache& cache = _cache;
+			std::lock_guard<std::mutex> lock(_idsMutex);
+			if (cache.epoch == _epoch.load(std::memory_order_relaxed))
+				for (; cache.count > 0; --cache.count)
+					_ids.push(cache.ids[cache.count-1]);
+			cache.count = 0;
+		}
+
 		static void destroyEntity(ent_type ent) {
-			_masks[ent.id].clear();
+			Mask& m = _masks[ent.id];
+			for (index_type i = 0; i <= compCounter; ++i) {
+				if (!m.test(Mask::bit(i)))
+					continue;
+				matchRemoved(i, ent);
+				StorageProfiler::del(i, true);
+				componentInfo[i].del(ent);
+				_columns[i].clear(ent.id);
+			}
+			m.clear();
 			_ids.push(ent);
 		}
+		/// Destroys n entities, visiting one component storage at a time.
+		static void destroyEntities(const ent_type* es, size_type n) {
+			for (index_type i = 0; i <= compCounter; ++i) {
+				const Mask::bit_type bit = Mask::bit(i);
+				for (size_type k = 0; k < n; ++k) {
+					if (!_masks[es[k].id].test(bit))
+						continue;
+					matchRemoved(i, es[k]);
+					StorageProfiler::del(i, true);
+					componentInfo[i].del(es[k]);
+					_columns[i].clear(es[k].id);
+				}
+			}
+			_ids.ensure(_ids.size()+n);
+			for (size_type k = 0; k < n; ++k) {
+				_masks[es[k].id].clear();
+				_ids.push(es[k]);
+			}
+		}
+		/// Destroys every entity and releases all storages. With Alloc::Arena
+		/// the memory of the whole world is reclaimed by a single arena reset.
+		static void reset() {
+			StorageProfiler::reset();
+			for (index_type i = 0; i <= compCounter; ++i) {
+				componentInfo[i].reset();
+				_columns[i].release();
+			}
+			_masks.release();
+			_ids.release();
+			_maxId = -1;
+			_epoch.fetch_add(1);
+			for (QueryBase* q = _queries; q != nullptr; q = q->_next)
+				q->clear();
+			BagAllocator::reset();
+		}
 		static const Mask& mask(ent_type e) {
 			return _masks[e.id];
 		}
-		static ent_type maxId() { return _maxId; }
+		static ent_type maxId() { return {_maxId.load(std::memory_order_relaxed)}; }
+		/// Live entities: ids handed out minus those waiting for reuse.
+		static size_type entities() { return maxId().id+1 - _ids.size(); }
+
+		static WorldReport report() {
+			WorldReport r{};
+			r.freeIds = _ids.size();
+			r.maxId = maxId().id;
+			r.entities = entities();
+			r.maskBytes = _masks.bytes();
+			r.maskGrowths = _masks.growths();
+			r.componentCount = compCounter+1;
+			for (index_type i = 0; i <= compCounter; ++i) {
+				const ComponentInfo& info = componentInfo[i];
+				r.columnBytes += _columns[i].bytes();
+				r.components[i] = {i, info.name, info.size, info.stats(_columns[i].count())};
+			}
+			return r;
+		}
 
 		template <class T>
 		static T& getComponent(ent_type e) {
+			StorageProfiler::get(Component<T>::Index, e.id);
 			return Storage<T>::type::get(e);
 		}
 
 		template <class T>
 		static void addComponent(ent_type e, const T& t) {
+			const bool had = _masks[e.id].test(Component<T>::Bit);
+			StorageProfiler::add(Component<T>::Index, e.id, had);
 			_masks[e.id].set(Component<T>::Bit);
+			_columns[Component<T>::Index].set(e.id);
 			Storage<T>::type::add(e,t);
+			if (!had)
+				matchAdded(Component<T>::Index, e);
+		}
+		template <class T, class = std::enable_if_t<!std::is_reference_v<T>>>
+		static void addComponent(ent_type e, T&& t) {
+			const bool had = _masks[e.id].test(Component<T>::Bit);
+			StorageProfiler::add(Component<T>::Index, e.id, had);
+			_masks[e.id].set(Component<T>::Bit);
+			_columns[Component<T>::Index].set(e.id);
+			Storage<T>::type::add(e,std::move(t));
+			if (!had)
+				matchAdded(Component<T>::Index, e);
+		}
+		template <class T, class ...Args>
+		static void emplaceComponent(ent_type e, Args&&... args) {
+			const bool had = _masks[e.id].test(Component<T>::Bit);
+			StorageProfiler::add(Component<T>::Index, e.id, had);
+			_masks[e.id].set(Component<T>::Bit);
+			_columns[Component<T>::Index].set(e.id);
+			Storage<T>::type::emplace(e,std::forward<Args>(args)...);
+			if (!had)
+				matchAdded(Component<T>::Index, e);
 		}
 		template <class T, class...Ts>
 		static void addComponents(ent_type e, const T& t, const Ts&... ts) {
@@ -249,9 +1502,25 @@ namespace bagel
 				addComponents(e, ts...);
 		}
 
+		/// Sorts the packed storage of T with cmp(const T&, const T&).
+		template <class T, class Compare>
+		static void sort(Compare cmp) {
+			Storage<T>::type::sort(cmp);
+		}
+		/// Sorts the packed storage of T to follow the order of U's packed storage.
+		template <class T, class U>
+		static void sort() {
+			Storage<T>::type::template sortAs<typename Storage<U>::type>();
+		}
+
 		template <class T>
 		static void delComponent(ent_type e) {
+			const bool had = _masks[e.id].test(Component<T>::Bit);
+			StorageProfiler::del(Component<T>::Index, had);
+			if (had)
+				matchRemoved(Component<T>::Index, e);
 			_masks[e.id].clear(Component<T>::Bit);
+			_columns[Component<T>::Index].clear(e.id);
 			Storage<T>::type::del(e);
 		}
 		template <class T, class ...Ts>
@@ -261,10 +1530,178 @@ namespace bagel
 				delComponents<Ts...>(e);
 		}
 
+		/// Calls f(ent_type) for every entity that has all of Ts, in id order.
+		template <class T, class ...Ts, class F>
+		static void forEach(F&& f) {
+			const index_type indices[] = {Component<T>::Index, Component<Ts>::Index...};
+			forEach(indices, 1+sizeof...(Ts), f);
+		}
+		template <class F>
+		static void forEach(const index_type* indices, size_type count, F&& f) {
+			forEach(indices, count, 0, words(indices, count), f);
+		}
+
+		/// Like forEach, but splits the id range into chunks of whole cache lines
+		/// of bitset words and runs them on the shared ThreadPool. f must be safe
+		/// to call concurrently; structural changes go through CommandBuffer.
+		template <class T, class ...Ts, class F>
+		static void parallelForEach(F&& f) {
+			const index_type indices[] = {Component<T>::Index, Component<Ts>::Index...};
+			parallelForEach(indices, 1+sizeof...(Ts), f);
+		}
+		template <class F>
+		static void parallelForEach(const index_type* indices, size_type count, F&& f) {
+			constexpr size_type LineWords = 64/sizeof(EntityBitset::word_type);
+
+			ThreadPool& pool = ThreadPool::shared();
+			const size_type total = words(indices, count);
+			const size_type perTask = total/(pool.threads()*4);
+			const size_type chunk = std::max(LineWords, (perTask + LineWords-1)/LineWords*LineWords);
+			const size_type tasks = (total + chunk-1)/chunk;
+
+			if (tasks <= 1) {
+				forEach(indices, count, 0, total, f);
+				return;
+			}
+			pool.run(tasks, [&](size_type t) {
+				forEach(indices, count, t*chunk, std::min(total, (t+1)*chunk), f);
+			});
+		}
+
 	private:
-		static inline ent_type								_maxId{-1};
-		static inline Bag<Mask,		Params.InitialEntities> _masks;
+		template <class ...> friend class Prefab;
+		friend class QueryBase;
+
+		// Component c was just added to e: queries on c that e now satisfies gain it
+		static void matchAdded(index_type c, ent_type e) {
+			const Mask& m = _masks[e.id];
+			for (QueryBase* q = _queriesFor[c]; q != nullptr; q = q->_nextFor[c])
+				if (m.test(q->_mask))
+					q->insert(e);
+		}
+		// Component c is being removed from e: queries on c that held e lose it
+		static void matchRemoved(index_type c, ent_type e) {
+			for (QueryBase* q = _queriesFor[c]; q != nullptr; q = q->_nextFor[c])
+				if (q->has(e))
+					q->erase(e);
+		}
+		// es were created with all components of m at once
+		static void matchCreated(const ent_type* es, size_type n, const Mask& m) {
+			for (QueryBase* q = _queries; q != nullptr; q = q->_next)
+				if (m.test(q->_mask))
+					for (size_type i = 0; i < n; ++i)
+						q->insert(es[i]);
+		}
+
+		template <class T>
+		static void addComponent(const ent_type* es, size_type n, const T& t) {
+			EntityBitset& column = _columns[Component<T>::Index];
+			for (size_type i = 0; i < n; ++i) {
+				StorageProfiler::add(Component<T>::Index, es[i].id, false);
+				column.set(es[i].id);
+			}
+			Storage<T>::type::add(es, n, t);
+		}
+
+		static size_type words(const index_type* indices, size_type count) {
+			size_type n = _columns[indices[0]].words();
+			for (size_type c = 1; c < count; ++c)
+				n = std::min(n, _columns[indices[c]].words());
+			return n;
+		}
+
+		// Visits the matching entities stored in bitset words [first, last)
+		template <class F>
+		static void forEach(const index_type* indices, size_type count,
+							index_type first, index_type last, F& f) {
+			using word_type = EntityBitset::word_type;
+			constexpr size_type WordBits = EntityBitset::WordBits;
+			constexpr size_type GroupWords = EntityBitset::GroupWords;
+
+			const word_type* words[Params.MaxComponents];
+			const word_type* summaries[Params.MaxComponents];
+			for (size_type c = 0; c < count; ++c) {
+				words[c] = _columns[indices[c]].wordData();
+				summaries[c] = _columns[indices[c]].summaryData();
+			}
+
+			for (index_type s = first/WordBits; s*WordBits < last; ++s) {
+				word_type summary = summaries[0][s];
+				for (size_type c = 1; c < count && summary; ++c)
+					summary &= summaries[c][s];
+
+				const index_type lo = std::max(first - s*WordBits, 0);
+				const index_type hi = std::min(last - s*WordBits, WordBits);
+				summary &= (hi == WordBits ? ~word_type{0} : (word_type{1} << hi)-1) & ~((word_type{1} << lo)-1);
+
+				// Visit each group of 4 words that has a candidate word
+				while (summary) {
+					const int group = ctz(summary)/GroupWords;
+					summary &= ~(word_type{0xF} << (group*GroupWords));
+					const index_type base = s*WordBits + group*GroupWords;
+
+					alignas(32) word_type acc[GroupWords];
+					andGroup(words, count, base, acc);
+
+					for (size_type i = 0; i < GroupWords; ++i) {
+						for (word_type w = acc[i]; w; w &= w-1)
+							f(ent_type{static_cast<id_type>((base+i)*WordBits + ctz(w))});
+					}
+				}
+			}
+		}
+
+		static int ctz(EntityBitset::word_type w) {
+			return __builtin_ctzll(w);
+		}
+		static void andGroup(const EntityBitset::word_type* const* words, size_type count,
+							 index_type base, EntityBitset::word_type* out) {
+#if defined(__AVX2__)
+			__m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words[0]+base));
+			for (size_type c = 1; c < count; ++c)
+				acc = _mm256_and_si256(acc,
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words[c]+base)));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(out), acc);
+#else
+			for (size_type i = 0; i < EntityBitset::GroupWords; ++i) {
+				out[i] = words[0][base+i];
+				for (size_type c = 1; c < count; ++c)
+					out[i] &= words[c][base+i];
+			}
+#endif
+		}
+
+		using IdCache = EntityIdCache;
+
+		static void refill(IdCache& cache) {
+			const unsigned epoch = _epoch.load(std::memory_order_relaxed);
+			if (cache.epoch != epoch) {
+				cache.epoch = epoch;
+				cache.count = 0;
+			}
+			{
+				std::lock_guard<std::mutex> lock(_idsMutex);
+				for (; cache.count < Params.IdCacheSize/2 && _ids.size() > 0; ++cache.count)
+					cache.ids[cache.count] = _ids.pop();
+			}
+			if (cache.count > 0)
+				return;
+			const id_type first = _maxId.fetch_add(Params.IdCacheSize)+1;
+			_masks.ensure(first+Params.IdCacheSize-1);
+			// Stored last-first so the ids are handed out in increasing order
+			for (id_type id = first+Params.IdCacheSize-1; id >= first; --id)
+				cache.ids[cache.count++] = {id};
+		}
+
+		static inline QueryBase*								_queries = nullptr;
+		static inline QueryBase*								_queriesFor[Params.MaxComponents] = {};
+		static inline std::atomic<id_type>					_maxId{-1};
+		static inline MaskPages								_masks;
 		static inline Bag<ent_type,	Params.IdBagSize>		_ids;
+		static inline std::mutex							_idsMutex;
+		static inline std::atomic<unsigned>					_epoch{0};
+		static inline thread_local IdCache					_cache;
+		static inline EntityBitset							_columns[Params.MaxComponents];
 	};
 
 	class Entity
@@ -282,6 +1719,13 @@ namespace bagel
 		template <class T> void add(const T& t) const {
 			return World::addComponent<T>(_ent, t);
 		}
+		template <class T, class = std::enable_if_t<!std::is_reference_v<T>>>
+		void add(T&& t) const {
+			return World::addComponent<T>(_ent, std::move(t));
+		}
+		template <class T, class ...Args> void emplace(Args&&... args) const {
+			return World::emplaceComponent<T>(_ent, std::forward<Args>(args)...);
+		}
 		template <class T> void del() const {
 			return World::delComponent<T>(_ent);
 		}
@@ -299,6 +1743,165 @@ namespace bagel
 		ent_type _ent;
 	};
 
+	/// Component set with default values, instantiated as a whole.
+	/// The mask is computed once; instantiating N entities copies it once per entity
+	/// and appends to each component storage in a single bulk add.
+	template <class ...Ts>
+	class Prefab
+	{
+	public:
+		explicit Prefab(const Ts&... ts) : _defaults(ts...) {
+			(_mask.set(Component<Ts>::Bit), ...);
+		}
+
+		ent_type instantiate() const {
+			ent_type e;
+			instantiate(&e, 1);
+			return e;
+		}
+		void instantiate(ent_type* out, size_type n) const {
+			World::createEntities(out, n, _mask);
+			(World::addComponent<Ts>(out, n, std::get<Ts>(_defaults)), ...);
+			World::matchCreated(out, n, _mask);
+		}
+
+		template <class T> T& defaults() { return std::get<T>(_defaults); }
+		template <class T> const T& defaults() const { return std::get<T>(_defaults); }
+		const Mask& mask() const { return _mask; }
+	private:
+		std::tuple<Ts...>	_defaults;
+		Mask				_mask;
+	};
+
+	/// Structural changes recorded from parallel systems. Each thread appends
+	/// to its own buffer; flush() applies them on the main thread once the
+	/// parallel section is over. A command is a plain record whose payload, the
+	/// component or comparator, is stored inline in the thread's buffer.
+	class CommandBuffer final : NoInstance
+	{
+	public:
+		template <class T>
+		static void addComponent(ent_type e, T t) {
+			local().push(e, &applyAdd<T>, std::move(t));
+		}
+		/// Deferred World::sort<T>(cmp).
+		template <class T, class Compare>
+		static void sort(Compare cmp) {
+			local().push(ent_type{}, &applySort<T, Compare>, std::move(cmp));
+		}
+		/// Deferred World::sort<T,U>().
+		template <class T, class U>
+		static void sort() {
+			local().push(ent_type{}, &applySortAs<T, U>);
+		}
+
+		template <class T>
+		static void delComponent(ent_type e) {
+			local().push(e, &applyDel<T>);
+		}
+		static void destroyEntity(ent_type e) {
+			local().push(e, &applyDestroy);
+		}
+
+		static void flush() {
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (auto& buffer : _buffers) {
+				for (const Command& command : buffer->commands)
+					command.apply(command.e, command.payload);
+				buffer->clear();
+			}
+		}
+	private:
+		// One deferred operation: apply performs it on e and destroys the payload, if any
+		struct Command
+		{
+			void	(*apply)(ent_type, void*);
+			ent_type	e;
+			void*	payload;
+		};
+
+		// Commands and their payloads; both keep their memory across flushes, so a thread
+		// that queues no more than it did before does not allocate
+		class Buffer
+		{
+		public:
+			static constexpr std::size_t BlockSize = 4096;
+
+			void push(ent_type e, void (*apply)(ent_type, void*)) {
+				commands.push_back({apply, e, nullptr});
+			}
+			template <class P>
+			void push(ent_type e, void (*apply)(ent_type, void*), P&& payload) {
+				using T = std::decay_t<P>;
+				static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned command payload");
+				void* p = new (allocate(sizeof(T), alignof(T))) T(std::forward<P>(payload));
+				commands.push_back({apply, e, p});
+			}
+			void clear() {
+				commands.clear();
+				_block = 0;
+				_used = 0;
+			}
+
+			std::vector<Command>	commands;
+		private:
+			struct Block
+			{
+				std::unique_ptr<unsigned char[]>	data;
+				std::size_t							size;
+			};
+
+			// Payloads never move once written, so they need not be relocatable
+			void* allocate(std::size_t size, std::size_t align) {
+				for (;; ++_block, _used = 0) {
+					if (_block == _blocks.size()) {
+						const std::size_t n = std::max(size, BlockSize);
+						_blocks.push_back({std::make_unique<unsigned char[]>(n), n});
+					}
+					const std::size_t at = (_used + align-1) & ~(align-1);
+					if (at + size <= _blocks[_block].size) {
+						_used = at + size;
+						return _blocks[_block].data.get() + at;
+					}
+				}
+			}
+
+			std::vector<Block>	_blocks;
+			std::size_t			_block = 0;		// Block being filled
+			std::size_t			_used = 0;		// Bytes used in it
+		};
+
+		template <class T>
+		static void applyAdd(ent_type e, void* p) {
+			T& t = *static_cast<T*>(p);
+			World::addComponent<T>(e, std::move(t));
+			t.~T();
+		}
+		template <class T, class Compare>
+		static void applySort(ent_type, void* p) {
+			Compare& cmp = *static_cast<Compare*>(p);
+			World::sort<T>(cmp);
+			cmp.~Compare();
+		}
+		template <class T, class U>
+		static void applySortAs(ent_type, void*) { World::sort<T,U>(); }
+		template <class T>
+		static void applyDel(ent_type e, void*) { World::delComponent<T>(e); }
+		static void applyDestroy(ent_type e, void*) { World::destroyEntity(e); }
+
+		static Buffer& local() {
+			thread_local Buffer* buffer = [] {
+				std::lock_guard<std::mutex> lock(_mutex);
+				_buffers.push_back(std::make_unique<Buffer>());
+				return _buffers.back().get();
+			}();
+			return *buffer;
+		}
+
+		static inline std::mutex							_mutex;
+		static inline std::vector<std::unique_ptr<Buffer>>	_buffers;
+	};
+
 	class MaskBuilder
 	{
 	public:
@@ -311,4 +1914,137 @@ namespace bagel
 	private:
 		Mask m;
 	};
+
+	inline QueryBase::QueryBase(const index_type* indices, size_type count) : _count(count) {
+		for (size_type i = 0; i < count; ++i) {
+			const index_type c = indices[i];
+			_indices[i] = c;
+			_mask.set(Mask::bit(c));
+			_nextFor[c] = World::_queriesFor[c];
+			World::_queriesFor[c] = this;
+		}
+		_next = World::_queries;
+		World::_queries = this;
+		World::forEach(indices, count, [this](ent_type e) { insert(e); });
+	}
+
+	inline QueryBase::~QueryBase() {
+		QueryBase** link = &World::_queries;
+		while (*link != this)
+			link = &(*link)->_next;
+		*link = _next;
+		for (size_type i = 0; i < _count; ++i) {
+			const index_type c = _indices[i];
+			link = &World::_queriesFor[c];
+			while (*link != this)
+				link = &(*link)->_nextFor[c];
+			*link = _nextFor[c];
+		}
+	}
+
+	/// Components a pipeline system reads or writes for each entity.
+	template <class ...Ts> struct Components {};
+
+	template <class A, class B> struct SharedComponents;
+	template <class Shared, class ...Ss> struct FusedSystems;
+	template <class Done, class Current, class ...Ss> struct FuseSystems;
+
+	// Components of A that are also in B, in A's order
+	template <class ...As, class ...Bs>
+	struct SharedComponents<Components<As...>, Components<Bs...>> {
+		template <class T>
+		using Keep = std::conditional_t<(std::is_same_v<T, Bs> || ...), std::tuple<T>, std::tuple<>>;
+		template <class ...Ts>
+		static Components<Ts...> list(std::tuple<Ts...>*);
+		using type = decltype(list(static_cast<decltype(std::tuple_cat(std::declval<Keep<As>>()...))*>(nullptr)));
+	};
+
+	// One pass over the entities holding Ts, running each of Ss that matches
+	template <class ...Ts, class ...Ss>
+	struct FusedSystems<Components<Ts...>, Ss...> {
+		template <class ...Args>
+		static void run(const Args&... args) {
+			static Query<Ts...> query;
+			const Mask masks[] = {maskOf(static_cast<typename Ss::Components*>(nullptr))...};
+			const auto body = [&](ent_type e) {
+				const Mask& m = World::mask(e);
+				size_type i = 0;
+				(call<Ss>(e, m, masks[i++], args...), ...);
+			};
+			if constexpr ((isParallel<Ss>(0) && ...))
+				query.parallelForEach(body);
+			else
+				query.forEach(body);
+		}
+	private:
+		template <class ...Cs>
+		static Mask maskOf(Components<Cs...>*) {
+			Mask m;
+			(m.set(Component<Cs>::Bit), ...);
+			return m;
+		}
+		template <class S>
+		static constexpr auto isParallel(int) -> decltype(bool(S::Parallel)) { return S::Parallel; }
+		template <class S>
+		static constexpr bool isParallel(...) { return false; }
+
+		template <class S, class ...Args>
+		static void call(ent_type e, const Mask& has, const Mask& needs, const Args&... args) {
+			if (!std::is_same_v<typename S::Components, Components<Ts...>> && !has.test(needs))
+				return;
+			if constexpr (std::is_invocable_v<decltype(&S::each), ent_type, const Args&...>)
+				S::each(e, args...);
+			else
+				S::each(e);
+		}
+	};
+
+	// Moves Ss one by one into the current group while it still shares a
+	// component with them, and starts a new group otherwise
+	template <class ...Gs>
+	struct FuseSystems<std::tuple<Gs...>, std::tuple<>> {
+		using type = std::tuple<Gs...>;
+	};
+	template <class ...Gs, class Cur>
+	struct FuseSystems<std::tuple<Gs...>, Cur> {
+		using type = std::tuple<Gs..., Cur>;
+	};
+	template <class S, class ...Ss>
+	struct FuseSystems<std::tuple<>, std::tuple<>, S, Ss...>
+		: FuseSystems<std::tuple<>, FusedSystems<typename S::Components, S>, Ss...> {};
+	template <class ...Gs, class Shared, class ...Fs, class S, class ...Ss>
+	struct FuseSystems<std::tuple<Gs...>, FusedSystems<Shared, Fs...>, S, Ss...> {
+		using Next = typename SharedComponents<Shared, typename S::Components>::type;
+		using type = typename std::conditional_t<std::is_same_v<Next, Components<>>,
+			FuseSystems<std::tuple<Gs..., FusedSystems<Shared, Fs...>>, FusedSystems<typename S::Components, S>, Ss...>,
+			FuseSystems<std::tuple<Gs...>, FusedSystems<Next, Fs..., S>, Ss...>>::type;
+	};
+
+	/// Runs systems in order, fusing runs of adjacent systems that share at
+	/// least one component into a single pass over the entities holding the
+	/// shared components. A system S declares
+	///   using Components = bagel::Components<...>;
+	///   static void each(ent_type e[, args...]);
+	/// and optionally static constexpr bool Parallel = true. each runs for the
+	/// entities that hold all of S::Components, and may only touch the entity it
+	/// is given: a fused pass runs every system on one entity before moving on.
+	/// A group runs on the shared pool when all of its systems are Parallel.
+	template <class ...Ss>
+	class Pipeline final : NoInstance
+	{
+	public:
+		using Groups = typename FuseSystems<std::tuple<>, std::tuple<>, Ss...>::type;
+		static constexpr size_type GroupCount = std::tuple_size_v<Groups>;
+
+		/// Runs every group; each system's each gets args if it takes them.
+		template <class ...Args>
+		static void run(const Args&... args) {
+			run(static_cast<Groups*>(nullptr), args...);
+		}
+	private:
+		template <class ...Gs, class ...Args>
+		static void run(std::tuple<Gs...>*, const Args&... args) {
+			(Gs::run(args...), ...);
+		}
+	};
 }
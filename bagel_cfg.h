@@ -1,7 +1,9 @@
 #pragma once
 
 constexpr Bagel Params{
-	.DynamicResize = true
+	.DynamicResize = true,
+	.MaxComponents = 32
 };
 
+// Build with BAGEL_PROFILE_STORAGE defined to print recommended lines at exit
 //BAGEL_STORAGE(Position,PackedStorage)
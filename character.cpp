@@ -1,8 +1,14 @@
 #include "character.h"
+#include "InputQueue.h"
+#include "Mario.h"
+#include "RenderQueue.h"
+#include "TextureCache.h"
 #include <iostream>
 #include <SDL3/SDL.h>
-#include <SDL3_image/SDL_image.h>
 #include <box2d/box2d.h>
+#include <chrono>
+#include <thread>
+#include <iterator>
 #include <vector>
 
 using namespace character;
@@ -19,18 +25,11 @@ Mario::Mario()
         std::cout << SDL_GetError() << std::endl;
         return;
     }
-    SDL_Surface *surf = IMG_Load("res/Mario.png");
-    if (surf == nullptr) {
-        std::cout << SDL_GetError() << std::endl;
-        return;
-    }
-
-    tex = SDL_CreateTextureFromSurface(ren, surf);
+    tex = mario::TextureCache().load(ren, "res/Mario.png");
     if (tex == nullptr) {
         std::cout << SDL_GetError() << std::endl;
         return;
     }
-    SDL_DestroySurface(surf);
 }
 
 Mario::~Mario()
@@ -45,15 +44,74 @@ Mario::~Mario()
     SDL_Quit();
 }
 
+bool SquenceScript::advance()
+{
+    SCRIPT_BEGIN(_state);
+    for (_step = 0; _step < _count; ++_step) {
+        for (_frame = 0; _frame < _steps[_step].frame; ++_frame) {
+            play(_steps[_step], _frame);
+            SCRIPT_WAIT(_state, FRAME_TICKS);
+        }
+    }
+    SCRIPT_END(_state);
+}
+
+void SquenceScript::play(const CharacterAnimations::Squence& s, int j)
+{
+    auto flip = SDL_FLIP_NONE;
+    int k = j;
+    if (s.reverse)
+        k = s.frame - j;
+    else
+        k = j;
+
+    if (s.action == CharacterAnimations::Action::SMALL_MARIO_JUMP || s.action == CharacterAnimations::Action::BIG_MARIO_JUMP) {
+        if (j < s.frame/2) {
+            _r.y -= 3 * CharacterAnimations::SCALE_CHARACTER;
+        } else {
+            _r.y += 3 * CharacterAnimations::SCALE_CHARACTER;
+        }
+    }
+    if (s.action == CharacterAnimations::Action::SMALL_MARIO_WALK || s.action == CharacterAnimations::Action::BIG_MARIO_WALK) {
+        if (s.left) {
+            _r.x -= 3 * CharacterAnimations::SCALE_CHARACTER;
+        } else _r.x += 3 * CharacterAnimations::SCALE_CHARACTER;
+    }
+    if (s.action == CharacterAnimations::Action::SMALL_MARIO_STOP || s.action == CharacterAnimations::Action::BIG_MARIO_STOP) {
+        if (s.left) {
+            _r.x -= 1 * CharacterAnimations::SCALE_CHARACTER;
+        } else _r.x += 1 * CharacterAnimations::SCALE_CHARACTER;
+    }
+    if (s.left) {
+        flip = SDL_FLIP_HORIZONTAL;
+    }
+
+    const SDL_FRect rect = CharacterAnimations::getFrame(CharacterAnimations::MARIO, s.action, k);
+
+    _r.h = rect.h * CharacterAnimations::SCALE_CHARACTER;
+    _r.w = rect.w * CharacterAnimations::SCALE_CHARACTER;
+
+    if (s.action == CharacterAnimations::Action::GROW_SHRINK) {
+        switch (j) {
+            case 1: case 3: case 4: case 6:
+                _r.y -= 8 * (s.reverse ? -1 : 1) * CharacterAnimations::SCALE_CHARACTER;
+                break;
+            case 2: case 5:
+                _r.y += 8 * (s.reverse ? -1 : 1) * CharacterAnimations::SCALE_CHARACTER;
+                break;
+            default:
+                break;
+        }
+    }
+
+    _command = {_tex, rect, _r, 0, flip};
+}
+
 void Mario::run()
 {
     SDL_SetRenderDrawColor(ren, 0,0,0,255);
-    SDL_FRect r {200,300, 0, 0};
 
-    SDL_Event event;
-    SDL_FRect rect;
-
-    std::vector<CharacterAnimations::Squence> seq = {
+    static const CharacterAnimations::Squence seq[] = {
             {CharacterAnimations::Action::SMALL_MARIO_STAND, 3},
             {CharacterAnimations::Action::SMALL_MARIO_WALK, 10},
             {CharacterAnimations::Action::SMALL_MARIO_STOP, 6},
@@ -67,71 +125,38 @@ void Mario::run()
             {CharacterAnimations::Action::BIG_MARIO_WALK, 25, true},
     };
 
-
-    for (auto & s : seq) {
-        for (int j = 0; j < s.frame; ++j) {
-            while (SDL_PollEvent(&event)) {
-                if (event.type == SDL_EVENT_QUIT) {
-                    return;
-                }
-            }
-
-            auto flip = SDL_FLIP_NONE;
-            int k = j;
-            if (s.reverse)
-                k = s.frame - j;
-            else
-                k = j;
-
-            if (s.action == CharacterAnimations::Action::SMALL_MARIO_JUMP || s.action == CharacterAnimations::Action::BIG_MARIO_JUMP) {
-                if (j < s.frame/2) {
-                    r.y -= 3 * CharacterAnimations::SCALE_CHARACTER;
-                } else {
-                    r.y += 3 * CharacterAnimations::SCALE_CHARACTER;
-                }
-            }
-            if (s.action == CharacterAnimations::Action::SMALL_MARIO_WALK || s.action == CharacterAnimations::Action::BIG_MARIO_WALK) {
-                if (s.left) {
-                    r.x -= 3 * CharacterAnimations::SCALE_CHARACTER;
-                } else r.x += 3 * CharacterAnimations::SCALE_CHARACTER;
-            }
-            if (s.action == CharacterAnimations::Action::SMALL_MARIO_STOP || s.action == CharacterAnimations::Action::BIG_MARIO_STOP) {
-                if (s.left) {
-                    r.x -= 1 * CharacterAnimations::SCALE_CHARACTER;
-                } else r.x += 1 * CharacterAnimations::SCALE_CHARACTER;
-            }
-            if (s.left) {
-                flip = SDL_FLIP_HORIZONTAL;
-            }
-
-        rect = CharacterAnimations::getFrame(CharacterAnimations::MARIO,
-                                             s.action,
-                                             k);
-
-        r.h = rect.h * CharacterAnimations::SCALE_CHARACTER;
-        r.w = rect.w * CharacterAnimations::SCALE_CHARACTER;
-
-        if (s.action == CharacterAnimations::Action::GROW_SHRINK) {
-            switch (j) {
-            case 1: case 3: case 4: case 6:
-                    r.y -= 8 * (s.reverse ? -1 : 1) * CharacterAnimations::SCALE_CHARACTER;
-                    break;
-                case 2: case 5:
-                    r.y += 8 * (s.reverse ? -1 : 1) * CharacterAnimations::SCALE_CHARACTER;
-                    break;
-                default:
-                    break;
-            }
+    // Every character plays its own copy of the sequence; all of them are resumed by one
+    // scheduler on the simulation thread, which sleeps only to hold the tick rate
+    mario::ScriptScheduler<SquenceScript> scripts(1);
+    scripts.add(SquenceScript(tex, seq, static_cast<int>(std::size(seq)), {200, 300, 0, 0}));
+
+    mario::InputQueue::start();
+
+    // The scripts are simulated on their own thread; the main thread pumps events and
+    // presents frame N while frame N+1 is being prepared
+    mario::RenderQueue frames;
+    mario::PerfOverlay perf;
+    std::thread sim([&] {
+        const auto tick = std::chrono::microseconds(1000000 / FPS);
+        auto next = std::chrono::steady_clock::now();
+        while (!mario::InputQueue::quitRequested()) {
+            const auto start = std::chrono::steady_clock::now();
+            mario::InputSystem::run();
+            const std::size_t running = scripts.tick(frames.begin());
+            const std::chrono::duration<float, std::milli> ms = std::chrono::steady_clock::now() - start;
+            perf.endSim(ms.count());
+            frames.submit();
+            if (running == 0)
+                break;
+
+            next += tick;
+            std::this_thread::sleep_until(next);
         }
+        frames.close();
+    });
 
-
-            SDL_RenderClear(ren);
-        SDL_RenderTextureRotated(
-                ren, tex, &rect, &r, 0,
-                nullptr, flip);
-        SDL_RenderPresent(ren);
-
-        SDL_Delay(70);
-        }
-    }
+    while (frames.present(ren, &perf))
+        SDL_PumpEvents();
+    sim.join();
+    mario::InputQueue::stop();
 }
@@ -2,7 +2,10 @@
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
 #include <box2d/box2d.h>
+#include <vector>
 #include "character_data.h"
+#include "RenderQueue.h"
+#include "Script.h"
 
 namespace character {
     class Mario
@@ -98,4 +101,41 @@ namespace character {
 
     };
 
+    /// @brief Plays a list of Squence steps for one character without blocking.
+    ///
+    /// Each resume draws the character once; a new animation frame starts every
+    /// FRAME_TICKS resumes. Many scripts can share one ScriptScheduler.
+    class SquenceScript
+    {
+    public:
+        static constexpr int FRAME_TICKS = 4; // Scheduler ticks per animation frame
+
+        /// @param steps Steps to play, which must outlive the script.
+        /// @param start Screen position of the character; its size comes from the sprites.
+        SquenceScript(SDL_Texture* tex, const CharacterAnimations::Squence* steps, int count, SDL_FRect start)
+            : _tex(tex), _steps(steps), _count(count), _r(start) {}
+
+        /// @brief Advances the script by one tick and adds the character to frame.
+        /// Returns false once every step has played.
+        bool resume(std::vector<mario::RenderCommand>& frame) {
+            const bool running = advance();
+            if (_command.texture != nullptr)
+                frame.push_back(_command);
+            return running;
+        }
+
+    private:
+        bool advance();
+        void play(const CharacterAnimations::Squence& s, int j);
+
+        SDL_Texture* _tex;
+        const CharacterAnimations::Squence* _steps;
+        int _count;
+        SDL_FRect _r;
+        mario::RenderCommand _command = {};
+
+        mario::ScriptState _state;
+        int _step = 0, _frame = 0;
+    };
+
 }
\ No newline at end of file
@@ -1,9 +1,63 @@
 #include "character.h"
+#include "Replay.h"
+#include "Stress.h"
 #include "SDL3/SDL.h"
 #include "SDL3_image/SDL_image.h"
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    // --record <file> plays live and saves the input; --replay <file> reruns it headless
+    if (argc == 3 && std::strcmp(argv[1], "--record") == 0) {
+        if (!SDL_Init(SDL_INIT_VIDEO)) {
+            std::cout << SDL_GetError() << std::endl;
+            return 1;
+        }
+        SDL_Window* win = nullptr;
+        SDL_Renderer* ren = nullptr;
+        if (!SDL_CreateWindowAndRenderer("Mario (recording)", 800, 600, 0, &win, &ren)) {
+            std::cout << SDL_GetError() << std::endl;
+            SDL_Quit();
+            return 1;
+        }
+        const bool ok = mario::ReplayRunner::record(argv[2], SDL_GetTicks(), ren);
+        SDL_DestroyRenderer(ren);
+        SDL_DestroyWindow(win);
+        SDL_Quit();
+        return ok ? 0 : 1;
+    }
+
+    if (argc == 3 && std::strcmp(argv[1], "--replay") == 0) {
+        mario::InputReplay replay(argv[2]);
+        if (!replay.isOpen()) {
+            std::cout << "Cannot read replay " << argv[2] << std::endl;
+            return 1;
+        }
+        const mario::ReplayProfile profile = mario::ReplayRunner::run(replay);
+        const std::string csv = std::string(argv[2]) + ".csv";
+        profile.writeCsv(csv.c_str());
+        std::cout << replay.ticks() << " ticks in " << profile.totalMs << " ms, state hash "
+                  << std::hex << profile.stateHash << std::dec << ", timings in " << csv << std::endl;
+        return 0;
+    }
+
+    // --stress [entities] [ticks] measures the systems on a large churning scene
+    if (argc >= 2 && std::strcmp(argv[1], "--stress") == 0) {
+        const int entities = argc >= 3 ? std::atoi(argv[2]) : 10000;
+        const int ticks = argc >= 4 ? std::atoi(argv[3]) : 600;
+        mario::StressScene::run(mario::StressConfig::scaled(entities, ticks)).print(std::cout);
+        return 0;
+    }
+
+    // --play [level.bglv] plays a compiled level
+    if (argc >= 2 && std::strcmp(argv[1], "--play") == 0) {
+        mario::Mario game(argc >= 3 ? argv[2] : mario::Mario::DEFAULT_LEVEL);
+        game.run();
+        return 0;
+    }
 
-int main() {
     character::Mario mk;
     mk.run();
-}
\ No newline at end of file
+}
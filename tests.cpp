@@ -1,9 +1,41 @@
+#include <algorithm>
 #include <iostream>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
 #include "bagel.h"
 using namespace std;
 using namespace bagel;
 
+// Counts heap allocations so tests can check that a path does not allocate
+static atomic<long> heapAllocs{0};
+void* operator new(size_t n) {
+	++heapAllocs;
+	if (void* p = malloc(n ? n : 1))
+		return p;
+	throw bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void* operator new(size_t n, const nothrow_t&) noexcept { ++heapAllocs; return malloc(n ? n : 1); }
+void* operator new[](size_t n, const nothrow_t&) noexcept { ++heapAllocs; return malloc(n ? n : 1); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+struct TestName { string name; vector<int> data; };
+struct TestOwner { unique_ptr<int> p; };
+template <> struct bagel::Storage<TestName> { using type = PackedStorage<TestName>; };
+template <> struct bagel::Storage<TestOwner> { using type = PackedStorage<TestOwner>; };
+struct TestDepth { int z; };
+struct TestLayer { int layer; };
+template <> struct bagel::Storage<TestDepth> { using type = PackedStorage<TestDepth>; };
+template <> struct bagel::Storage<TestLayer> { using type = PackedStorage<TestLayer>; };
+
 void test1() {
 	ent_type e0 = World::createEntity();
 	assert(e0.id == 0 && "First id is not 0");
@@ -18,7 +50,533 @@ void test1() {
 	cout << "Test 1 passed\n";
 }
 
+struct TestPos { float x, y; };
+struct TestVel { float dx, dy; };
+
+void test2() {
+	Prefab<TestPos,TestVel> prefab{TestPos{1,2}, TestVel{3,4}};
+
+	ent_type es[100];
+	prefab.instantiate(es, 100);
+	for (ent_type e : es) {
+		Entity ent{e};
+		assert(ent.has<TestPos>() && ent.has<TestVel>() && "Prefab mask not applied");
+		assert(ent.get<TestPos>().y == 2 && ent.get<TestVel>().dx == 3 && "Prefab defaults not copied");
+	}
+
+	World::destroyEntity(es[10]);
+	ent_type e = prefab.instantiate();
+	assert(e.id == es[10].id && "Prefab did not recycle destroyed id");
+
+	cout << "Test 2 passed\n";
+}
+
+struct TestTag { int tag; };
+
+void test3() {
+	const Mask m = MaskBuilder().set<TestPos>().set<TestTag>().build();
+
+	for (int i = 0; i < 1000; ++i) {
+		Entity ent = Entity::create();
+		if (i % 3 == 0) ent.add(TestPos{});
+		if (i % 5 == 0) ent.add(TestTag{i});
+		if (i % 7 == 0 && i % 3 == 0) ent.del<TestPos>();
+	}
+
+	int expected = 0;
+	for (ent_type e = {0}; e.id <= World::maxId().id; ++e.id)
+		if (Entity{e}.test(m))
+			++expected;
+
+	int found = 0;
+	id_type last = -1;
+	World::forEach<TestPos,TestTag>([&](ent_type e) {
+		assert(e.id > last && "Query did not visit ids in order");
+		assert(Entity{e}.test(m) && "Query visited non-matching entity");
+		last = e.id;
+		++found;
+	});
+	assert(found == expected && "Query missed matching entities");
+
+	cout << "Test 3 passed\n";
+}
+
+void test4() {
+	World::reset();
+	void* a = ArenaAllocator::allocate(100);
+	void* b = ArenaAllocator::reallocate(a, 100, 200);
+	assert(a == b && "Arena did not grow last allocation in place");
+	ArenaAllocator::reset();
+	assert(ArenaAllocator::allocate(16) == a && "Arena reset did not rewind");
+	ArenaAllocator::reset();
+
+	void* p = PoolAllocator::allocate(100);
+	PoolAllocator::deallocate(p, 100);
+	assert(PoolAllocator::allocate(128) == p && "Pool did not reuse freed block");
+	PoolAllocator::deallocate(p, 128);
+
+	const std::size_t big = HugePageAllocator::PageSize*2;
+	char* h = static_cast<char*>(HugePageAllocator::allocate(big));
+	assert(h != nullptr && "Huge page allocation failed");
+	h[0] = h[big-1] = 1;
+	HugePageAllocator::deallocate(h, big);
+
+	for (int i = 0; i < 100; ++i)
+		Entity::create().add(TestPos{});
+	World::reset();
+	assert(World::maxId().id == -1 && "World reset did not clear ids");
+	Entity e = Entity::create();
+	assert(e.entity().id == 0 && !e.has<TestPos>() && "World reset left entity state behind");
+	e.add(TestPos{1,1});
+	assert(e.get<TestPos>().x == 1 && "Storage unusable after reset");
+
+	cout << "Test 4 passed\n";
+}
+
+void test5() {
+	World::reset();
+	for (int i = 0; i < 50; ++i) {
+		Entity e = Entity::create();
+		e.add(TestPos{});
+		if (i % 2 == 0)
+			e.add(TestVel{});
+	}
+	World::destroyEntity({3});
+
+	WorldReport r = World::report();
+	assert(r.entities == 49 && r.freeIds == 1 && "Report entity counts wrong");
+	bool seenPos = false;
+	for (const ComponentReport& c : r) {
+		if (c.index == Component<TestPos>::Index) {
+			seenPos = true;
+			assert(string(c.name) == "TestPos" && "Report component name wrong");
+			assert(c.storage.count == 49 && c.storage.capacity >= 50 && "Report storage counts wrong");
+			assert(c.storage.reservedBytes >= c.storage.usedBytes && c.storage.growths > 0 && "Report storage bytes wrong");
+		}
+		if (c.index == Component<TestVel>::Index)
+			assert(c.storage.count == 25 && "Report storage count wrong");
+	}
+	assert(seenPos && "Report missed registered component");
+	assert(r.maskGrowths == 1 && "Report mask growths wrong");
+	assert(r.maskBytes == sizeof(Mask)*MaskPages::PageSize + MaskPages::DirectoryBytes && "Report mask bytes wrong");
+	for (int i = 0; i < 2000; ++i)
+		Entity::create();
+	assert(World::report().maskGrowths == 3 && "Mask growths not counted per growth");
+
+	cout << "Test 5 passed\n";
+}
+
+void test6() {
+	vector<Entity> es;
+	for (int i = 0; i < 100; ++i) {
+		Entity e = Entity::create();
+		e.emplace<TestName>(string(40, 'a'+i%26), vector<int>(i, i));
+		e.add(TestOwner{make_unique<int>(i)});
+		es.push_back(e);
+	}
+	for (int i = 0; i < 100; i += 3) {
+		es[i].del<TestName>();
+		es[i].del<TestOwner>();
+	}
+	for (int i = 0; i < 100; ++i) {
+		if (i % 3 == 0) {
+			assert(!es[i].has<TestName>() && "Rich component not removed");
+			continue;
+		}
+		assert(es[i].get<TestName>().name == string(40, 'a'+i%26) && "Rich component corrupted by growth or delete");
+		assert(static_cast<int>(es[i].get<TestName>().data.size()) == i && "Rich component corrupted by growth or delete");
+		assert(*es[i].get<TestOwner>().p == i && "Move-only component corrupted by growth or delete");
+	}
+
+	cout << "Test 6 passed\n";
+}
+
+void test7() {
+	World::reset();
+	for (int i = 0; i < 100000; ++i) {
+		Entity e = Entity::create();
+		e.add(TestPos{static_cast<float>(i), 0});
+		if (i % 4 != 0)
+			e.add(TestVel{1, 0});
+	}
+
+	atomic<int> visited{0};
+	World::parallelForEach<TestPos,TestVel>([&](ent_type e) {
+		TestPos& p = World::getComponent<TestPos>(e);
+		p.y += World::getComponent<TestVel>(e).dx;
+		++visited;
+		if (e.id % 8 == 1)
+			CommandBuffer::destroyEntity(e);
+	});
+	assert(visited == 75000 && "Parallel query visited wrong number of entities");
+	for (ent_type e = {0}; e.id <= World::maxId().id; ++e.id)
+		assert(World::getComponent<TestPos>(e).y == (e.id % 4 != 0 ? 1 : 0) && "Parallel query visited an entity twice or not at all");
+
+	ThreadPool pool(4);
+	vector<atomic<int>> runs(1000);
+	for (int round = 0; round < 50; ++round)
+		pool.run(1000, [&](size_type t) {
+			++runs[t];
+			if (round == 0 && t % 100 == 0)
+				CommandBuffer::destroyEntity({t});
+		});
+	for (atomic<int>& r : runs)
+		assert(r == 50 && "Thread pool ran a task twice or not at all");
+
+	CommandBuffer::flush();
+	int alive = 0;
+	World::forEach<TestPos>([&](ent_type) { ++alive; });
+	assert(alive == 100000 - 12500 - 10 && "Deferred destroy not applied");
+
+	cout << "Test 7 passed\n";
+}
+
+void test8() {
+	using Depths = Storage<TestDepth>::type;
+	using Layers = Storage<TestLayer>::type;
+
+	vector<Entity> es;
+	for (int i = 0; i < 200; ++i) {
+		Entity e = Entity::create();
+		e.add(TestDepth{(i*37) % 101});
+		if (i % 3 != 0)
+			e.add(TestLayer{i});
+		es.push_back(e);
+	}
+	for (int i = 0; i < 200; i += 7)
+		es[i].del<TestDepth>();
+
+	World::sort<TestDepth>([](const TestDepth& a, const TestDepth& b) { return a.z < b.z; });
+	for (int i = 1; i < Depths::size(); ++i)
+		assert(Depths::get(i-1).z <= Depths::get(i).z && "Packed storage not sorted");
+	for (int i = 0; i < 200; ++i)
+		if (i % 7 != 0)
+			assert(es[i].get<TestDepth>().z == (i*37) % 101 && "Entity index broken by sort");
+
+	World::sort<TestLayer,TestDepth>();
+	int j = 0;
+	for (int i = 0; i < Depths::size(); ++i)
+		if (Layers::has(Depths::entity(i)))
+			assert(Layers::entity(j++).id == Depths::entity(i).id && "Packed storage not in order of other storage");
+	for (int i = 0; i < 200; ++i)
+		if (i % 3 != 0)
+			assert(es[i].get<TestLayer>().layer == i && "Entity index broken by sort");
+
+	cout << "Test 8 passed\n";
+}
+
+struct TestFlag {};
+struct TestRare { int v[8]; };
+
+void test9() {
+	World::reset();
+	vector<Entity> es;
+	for (int i = 0; i < 1000; ++i)
+		es.push_back(Entity::create());
+	for (auto& e : es)
+		e.add(TestFlag{});
+	for (int i = 0; i < 1000; i += 100)
+		es[i].add(TestRare{});
+	for (int i = 0; i < 1000; i += 100)
+		es[i].get<TestRare>().v[0] = i;
+
+	const string report = StorageProfiler::report();
+	if (StorageProfiler::Enabled) {
+		assert(report.find("BAGEL_STORAGE(TestFlag,TaggedStorage)") != string::npos && "Empty component not tagged");
+		assert(report.find("BAGEL_STORAGE(TestRare,PackedStorage)") != string::npos && "Rare component not packed");
+		World::reset();
+		const string fresh = StorageProfiler::report();
+		const size_t rare = fresh.find("BAGEL_STORAGE(TestRare,");
+		assert(rare != string::npos && fresh.find(", 0 gets (", rare) < fresh.find('\n', rare) &&
+			fresh.find(" 0 adds, 0 dels", rare) < fresh.find('\n', rare) && "World reset kept profiler counts");
+	} else {
+		assert(report.empty() && "Profiler reports without BAGEL_PROFILE_STORAGE");
+	}
+
+	cout << "Test 9 passed\n";
+}
+
+void test10() {
+	World::reset();
+	ThreadPool pool(4);
+	constexpr int Tasks = 64, PerTask = 100;
+
+	vector<ent_type> es(Tasks*PerTask);
+	pool.run(Tasks, [&](int t) {
+		for (int i = 0; i < PerTask/2; ++i)
+			es[t*PerTask+i] = World::createEntityConcurrent();
+		World::createEntitiesConcurrent(&es[t*PerTask+PerTask/2], PerTask/2);
+	});
+	vector<bool> seen(World::maxId().id+1);
+	for (ent_type e : es) {
+		assert(!seen[e.id] && "Id handed out twice");
+		seen[e.id] = true;
+		assert(Mask{}.test(World::mask(e)) && "Concurrently created entity has components");
+	}
+
+	// Destroyed ids are reused through the per-thread caches
+	for (int i = 0; i < Tasks*PerTask; i += 2)
+		World::destroyEntity(es[i]);
+	const id_type maxId = World::maxId().id;
+	World::flushIdCache();
+	pool.run(Tasks, [&](int t) {
+		for (int i = 0; i < PerTask/4; ++i)
+			es[t*PerTask+2*i] = World::createEntityConcurrent();
+	});
+	assert(World::maxId().id == maxId && "Recycled ids not reused");
+
+	cout << "Test 10 passed\n";
+}
+
+void test11() {
+	World::reset();
+	const auto same = [](const Query<TestPos,TestVel>& q) {
+		size_type n = 0;
+		World::forEach<TestPos,TestVel>([&](ent_type e) { assert(q.has(e) && "Query missing a match"); ++n; });
+		return n == q.size();
+	};
+
+	vector<Entity> es;
+	for (int i = 0; i < 100; ++i) {
+		es.push_back(Entity::create());
+		es.back().add(TestPos{});
+		if (i % 2 == 0)
+			es.back().add(TestVel{});
+	}
+	Query<TestPos,TestVel> q;
+	assert(q.size() == 50 && same(q) && "Query not populated on construction");
+
+	for (int i = 1; i < 100; i += 4)
+		es[i].add(TestVel{});
+	for (int i = 0; i < 100; i += 6)
+		es[i].del<TestVel>();
+	for (int i = 0; i < 100; i += 10)
+		es[i].destroy();
+	assert(same(q) && "Query out of date after add, del or destroy");
+
+	ent_type out[20];
+	Prefab<TestPos,TestVel>{TestPos{}, TestVel{}}.instantiate(out, 20);
+	assert(same(q) && "Query missed prefab instances");
+
+	World::reset();
+	assert(q.size() == 0 && "Query not cleared on reset");
+
+	cout << "Test 11 passed\n";
+}
+
+struct TestPosSystem {
+	using Components = bagel::Components<TestPos>;
+	static inline vector<int> order;
+	static void each(ent_type e) { order.push_back(e.id*10+1); }
+};
+struct TestVelSystem {
+	using Components = bagel::Components<TestPos,TestVel>;
+	static constexpr bool Parallel = true;
+	static void each(ent_type e, float dt) {
+		World::getComponent<TestVel>(e).dx += dt;
+		TestPosSystem::order.push_back(e.id*10+2);
+	}
+};
+struct TestDepthSystem {
+	using Components = bagel::Components<TestDepth>;
+	static void each(ent_type e) { TestPosSystem::order.push_back(e.id*10+3); }
+};
+
+void test12() {
+	World::reset();
+	using Fused = Pipeline<TestPosSystem,TestVelSystem,TestDepthSystem>;
+	static_assert(Fused::GroupCount == 2, "Systems sharing TestPos not fused");
+
+	for (int i = 0; i < 4; ++i) {
+		Entity e = Entity::create();
+		e.add(TestPos{});
+		if (i % 2 == 0)
+			e.add(TestVel{});
+		if (i == 3)
+			e.add(TestDepth{});
+	}
+	Fused::run(0.5f);
+
+	vector<int>& order = TestPosSystem::order;
+	for (int id = 0; id < 4; ++id) {
+		const auto first = find(order.begin(), order.end(), id*10+1);
+		assert(first != order.end() && "System not run for a match");
+		assert((id % 2 != 0 || *(first+1) == id*10+2) && "Fused systems not run one entity at a time");
+	}
+	assert(count_if(order.begin(), order.end(), [](int x) { return x%10 == 2; }) == 2 && "System run for a non-match");
+	assert(order.back() == 33 && "Groups not run in order");
+	assert(World::getComponent<TestVel>({0}).dx == 0.5f && "Arguments not passed to each");
+
+	cout << "Test 12 passed\n";
+}
+
+struct TestHeld { shared_ptr<int> p; };
+struct TestPackedHeld { shared_ptr<int> p; };
+template <> struct bagel::Storage<TestPackedHeld> { using type = PackedStorage<TestPackedHeld>; };
+
+void test13() {
+	World::reset();
+	const auto p = make_shared<int>(1);
+	vector<Entity> es;
+	for (int i = 0; i < 10; ++i) {
+		es.push_back(Entity::create());
+		es.back().add(TestHeld{p});
+		es.back().add(TestPackedHeld{p});
+	}
+	for (int i = 0; i < 10; i += 2)
+		es[i].destroy();
+	assert(p.use_count() == 11 && "Destroy left owned components alive");
+	for (int i = 1; i < 10; i += 2)
+		assert(es[i].get<TestHeld>().p == p && es[i].get<TestPackedHeld>().p == p && "Destroy corrupted other entities");
+
+	cout << "Test 13 passed\n";
+}
+
+void test14() {
+	World::reset();
+	Entity b = Entity::create();
+	Entity a = Entity::create();
+	a.add(TestDepth{50});
+	a.destroy();
+	Entity c = Entity::create();
+	assert(c.entity().id == a.entity().id && "Destroyed id not reused");
+	assert(!Storage<TestDepth>::type::has(c.entity()) && "Packed storage holds a destroyed entity");
+	b.add(TestDepth{20});
+	c.add(TestDepth{9});
+
+	CommandBuffer::sort<TestDepth>([](const TestDepth& x, const TestDepth& y) { return x.z < y.z; });
+	assert(Storage<TestDepth>::type::entity(0).id == b.entity().id && "Deferred sort ran before flush");
+	CommandBuffer::flush();
+	assert(c.get<TestDepth>().z == 9 && b.get<TestDepth>().z == 20 && "Sort mapped a reused id to a dead component");
+	assert(Storage<TestDepth>::type::entity(0).id == c.entity().id && "Deferred sort not applied");
+
+	cout << "Test 14 passed\n";
+}
+
+void test15() {
+	World::reset();
+	static Query<TestHeld, TestPackedHeld> q;
+	const auto p = make_shared<int>(1);
+	vector<ent_type> doomed;
+	vector<Entity> kept;
+	for (int i = 0; i < 10; ++i) {
+		Entity e = Entity::create();
+		e.add(TestHeld{p});
+		e.add(TestPackedHeld{p});
+		if (i % 3 == 0)
+			doomed.push_back(e.entity());
+		else
+			kept.push_back(e);
+	}
+	World::destroyEntities(doomed.data(), static_cast<size_type>(doomed.size()));
+	assert(p.use_count() == 1 + 2 * static_cast<long>(kept.size()) && "Bulk destroy left components alive");
+	assert(q.size() == static_cast<size_type>(kept.size()) && "Bulk destroy left entities in a query");
+	assert(World::entities() == static_cast<size_type>(kept.size()) && "Bulk destroy did not free the ids");
+	for (Entity e : kept)
+		assert(q.has(e.entity()) && e.get<TestPackedHeld>().p == p && "Bulk destroy corrupted other entities");
+
+	cout << "Test 15 passed\n";
+}
+
+void test16() {
+	World::reset();
+	static Query<TestHeld> q;
+	const auto p = make_shared<int>(1);
+	Entity before = Entity::create();
+	before.add(TestHeld{p});
+	q.trackAdded();
+
+	Entity late = Entity::create();
+	late.add(TestHeld{p});
+	vector<ent_type> added;
+	q.takeAdded([&](ent_type e) { added.push_back(e); });
+	assert(added.size() == 2 && added[0].id == before.entity().id && added[1].id == late.entity().id &&
+		"Tracking missed current or joining matches");
+
+	added.clear();
+	q.takeAdded([&](ent_type e) { added.push_back(e); });
+	assert(added.empty() && "takeAdded reported an entity twice");
+
+	late.destroy();
+	Entity last = Entity::create();
+	last.add(TestHeld{p});
+	q.takeAdded([&](ent_type e) { added.push_back(e); });
+	assert(added.size() == 1 && added[0].id == last.entity().id && "Leaving the query was reported as joining");
+
+	cout << "Test 16 passed\n";
+}
+
+struct TestAssigned {
+	static inline int assigns = 0;
+	string name;
+	TestAssigned() = default;
+	TestAssigned(string n) : name(std::move(n)) {}
+	TestAssigned(const TestAssigned&) = default;
+	TestAssigned& operator=(const TestAssigned& o) { ++assigns; name = o.name; return *this; }
+	TestAssigned& operator=(TestAssigned&& o) { ++assigns; name = std::move(o.name); return *this; }
+};
+
+void test17() {
+	static StaticBag<TestAssigned, 4> bag;
+	bag.push(TestAssigned{"first"});
+	bag.pop();
+	TestAssigned::assigns = 0;
+	TestAssigned& t = bag.emplace(string(40, 'x'));
+	assert(TestAssigned::assigns == 0 && "StaticBag emplace assigned a temporary");
+	assert(&t == &bag[0] && t.name == string(40, 'x') && bag.size() == 1 && "StaticBag emplace built the wrong slot");
+
+	cout << "Test 17 passed\n";
+}
+
+void test18() {
+	World::reset();
+	vector<Entity> es;
+	for (int i = 0; i < 64; ++i)
+		es.push_back(Entity::create());
+
+	for (Entity& e : es)
+		CommandBuffer::addComponent(e.entity(), TestName{string(40, 'a'), vector<int>(3, e.entity().id)});
+	CommandBuffer::flush();
+	for (Entity& e : es)
+		assert(e.get<TestName>().name == string(40, 'a') && e.get<TestName>().data[2] == e.entity().id &&
+			"Deferred add lost its payload");
+
+	// Once the buffer has held a round of commands, queueing and applying one allocates nothing
+	const auto round = [&] {
+		for (Entity& e : es)
+			CommandBuffer::addComponent(e.entity(), TestRare{{e.entity().id}});
+		CommandBuffer::flush();
+		for (Entity& e : es)
+			CommandBuffer::delComponent<TestRare>(e.entity());
+		CommandBuffer::flush();
+	};
+	round();
+	const long before = heapAllocs;
+	round();
+	assert(heapAllocs == before && "Command buffer allocated at steady state");
+	assert(!es[5].has<TestRare>() && "Deferred delete not applied");
+
+	cout << "Test 18 passed\n";
+}
+
 void run_tests()
 {
 	test1();
+	test2();
+	test3();
+	test4();
+	test5();
+	test6();
+	test7();
+	test8();
+	test9();
+	test10();
+	test11();
+	test12();
+	test13();
+	test14();
+	test15();
+	test16();
+	test17();
+	test18();
 }
@@ -0,0 +1,178 @@
+// levelc: compiles a text level description into the binary format LevelFile maps.
+//
+// Usage: levelc <level.lvl> <level.bglv>
+//
+// The description has one directive per line; '#' starts a comment.
+//   size <columns> <rows>                    Size of the level in tiles, given first
+//   tile <symbol> <srcX> <srcY> [decor]      Static tile drawn from the sheet, solid unless decor
+//   block <symbol> <BlockType> [<Collectable>]  Dynamic block, spawned as an entity
+//   enemy <column> <row> <EnemyType> <score>
+//   item <column> <row> <Collectable> <score>
+//   row <symbols>                            Next tile row, top to bottom; undefined symbols are empty
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "LevelFile.h"
+
+namespace {
+    using namespace mario;
+
+    const char* const ENEMY_NAMES[] = {"Goomba", "Koopa", "BulletBill", "CheepCheep", "HammerBro", "Bowser"};
+    const char* const BLOCK_NAMES[] = {"Brick", "Question", "Empty", "Solid"};
+    const char* const COLLECTABLE_NAMES[] = {"Coin", "Mushroom", "FireFlower", "Star", "Flag", "None"};
+
+    template <class E, std::size_t N>
+    bool parseEnum(const std::string& name, const char* const (&names)[N], E& out) {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (name == names[i]) {
+                out = static_cast<E>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct BlockDef {
+        bool defined = false;
+        BlockType type = BlockType::Brick;
+        CollectableType collectable = CollectableType::None;
+    };
+
+    class Compiler
+    {
+    public:
+        explicit Compiler(const char* path) : _path(path) {}
+
+        bool run(LevelData& level) {
+            std::ifstream in(_path);
+            if (!in)
+                return fail("cannot open file");
+
+            std::string line;
+            while (std::getline(in, line)) {
+                ++_line;
+                if (!directive(line, level))
+                    return false;
+            }
+            if (level.columns == 0)
+                return fail("missing size");
+
+            level.mergeSolids();
+            return true;
+        }
+
+    private:
+        bool directive(const std::string& line, LevelData& level) {
+            std::istringstream in(line);
+            std::string word;
+            if (!(in >> word) || word[0] == '#')
+                return true;
+
+            if (word == "size") {
+                if (!(in >> level.columns >> level.rows) || level.columns <= 0 || level.rows <= 0)
+                    return fail("bad size");
+                level.tiles.assign(static_cast<std::size_t>(level.columns) * level.rows, EMPTY_TILE);
+                return true;
+            }
+            if (level.columns == 0)
+                return fail("size must come first");
+
+            if (word == "tile") {
+                char symbol;
+                int srcX, srcY;
+                std::string kind;
+                if (!(in >> symbol >> srcX >> srcY))
+                    return fail("bad tile");
+                in >> kind;
+                level.tileDefs.push_back({static_cast<std::uint8_t>(symbol), kind != "decor",
+                                          static_cast<std::int16_t>(srcX), static_cast<std::int16_t>(srcY)});
+                _static[static_cast<std::uint8_t>(symbol)] = true;
+                return true;
+            }
+            if (word == "block") {
+                char symbol;
+                std::string type, collectable = "None";
+                if (!(in >> symbol >> type))
+                    return fail("bad block");
+                in >> collectable;
+                BlockDef& block = _blocks[static_cast<std::uint8_t>(symbol)];
+                block.defined = true;
+                if (!parseEnum(type, BLOCK_NAMES, block.type) ||
+                    !parseEnum(collectable, COLLECTABLE_NAMES, block.collectable))
+                    return fail("unknown block or collectable type");
+                return true;
+            }
+            if (word == "enemy" || word == "item") {
+                int column, row, score;
+                std::string type;
+                if (!(in >> column >> row >> type >> score))
+                    return fail("bad spawn");
+                Spawn s{word == "enemy" ? SpawnKind::Enemy : SpawnKind::Collectable};
+                s.x = static_cast<float>(column * LEVEL_TILE_SIZE);
+                s.y = static_cast<float>(row * LEVEL_TILE_SIZE);
+                s.scoreValue = score;
+                if (word == "enemy" ? !parseEnum(type, ENEMY_NAMES, s.enemy)
+                                    : !parseEnum(type, COLLECTABLE_NAMES, s.collectable))
+                    return fail("unknown spawn type");
+                level.spawns.push_back(s);
+                return true;
+            }
+            if (word == "row") {
+                if (_row == level.rows)
+                    return fail("more rows than the size allows");
+                const std::size_t start = line.find("row") + 4;
+                const std::string symbols = start < line.size() ? line.substr(start) : "";
+                for (int column = 0; column < static_cast<int>(symbols.size()) && column < level.columns; ++column)
+                    place(static_cast<std::uint8_t>(symbols[column]), column, level);
+                ++_row;
+                return true;
+            }
+            return fail("unknown directive '" + word + "'");
+        }
+
+        void place(std::uint8_t symbol, int column, LevelData& level) {
+            if (_static[symbol]) {
+                level.tiles[static_cast<std::size_t>(_row) * level.columns + column] = symbol;
+            } else if (_blocks[symbol].defined) {
+                Spawn s{SpawnKind::Block};
+                s.x = static_cast<float>(column * LEVEL_TILE_SIZE);
+                s.y = static_cast<float>(_row * LEVEL_TILE_SIZE);
+                s.block = _blocks[symbol].type;
+                s.collectable = _blocks[symbol].collectable;
+                level.spawns.push_back(s);
+            }
+        }
+
+        bool fail(const std::string& message) const {
+            std::cerr << _path << ":" << _line << ": " << message << std::endl;
+            return false;
+        }
+
+        const char* _path;
+        int _line = 0;
+        int _row = 0;
+        bool _static[256] = {};
+        BlockDef _blocks[256];
+    };
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "usage: levelc <level.lvl> <level.bglv>" << std::endl;
+        return 2;
+    }
+
+    LevelData level;
+    if (!Compiler(argv[1]).run(level))
+        return 1;
+    if (!LevelFile::write(argv[2], level)) {
+        std::cerr << argv[2] << ": cannot write" << std::endl;
+        return 1;
+    }
+    std::cout << argv[2] << ": " << level.columns << "x" << level.rows << " tiles, "
+              << level.spawns.size() << " spawns, " << level.solids.size() << " static boxes" << std::endl;
+    return 0;
+}